@@ -13,6 +13,8 @@ int main(int argc, char *argv[]) {
     const int iteration = weight < 5 ? 10 : 3;
     const auto start = std::chrono::steady_clock::now();
     for (EACH : range(iteration)) {
+      // Otherwise all iterations but the first would be served from the cache.
+      QLi_clear_cache();
       for (int num_args = 4; num_args <= total_points; num_args += 2) {
         for (const auto& seq : increasing_sequences(total_points, num_args)) {
           const auto args = mapped(seq, [](int x) { return x + 1; });
@@ -20,7 +22,7 @@ int main(int argc, char *argv[]) {
           expr += sign * QLiSymmVec(weight, args);
         }
       }
-      CHECK(to_lyndon_basis(expr).is_zero());
+      CHECK(to_lyndon_basis_parallel(expr).is_zero());
     }
     const auto finish = std::chrono::steady_clock::now();
     const double time_sec = (finish - start) / std::chrono::milliseconds(1) / 1000. / iteration;
@@ -0,0 +1,173 @@
+# Runs the same workload matrix (function x weight x number of points) through all QLi
+# backends, stores the results as JSON together with machine metadata, and compares them
+# against a baseline.
+#
+# Backends:
+#   - "cpp_native" is 'benchmark_qli.cpp';
+#   - "cpp", "hybrid" and "python" are the corresponding modes of 'benchmark_qli.py'.
+#
+# Usage (from the repository root):
+#   python3 benchmark/benchmark_harness.py --output results.json
+#   python3 benchmark/benchmark_harness.py --baseline benchmark/baseline.json
+#   python3 benchmark/benchmark_harness.py --baseline benchmark/baseline.json --update-baseline
+#
+# Exits with code 1 if any workload is slower than the baseline by more than the threshold.
+# Baselines are only comparable when recorded on the same machine; a warning is printed
+# otherwise.
+
+import argparse
+import datetime
+import json
+import os
+import platform
+import subprocess
+import sys
+
+
+REPO_ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+BAZEL_RUN = ["bazel", "run", "-c", "opt", "--config=clang"]
+
+BACKENDS = {
+    "cpp_native": BAZEL_RUN + ["//benchmark:benchmark_qli_cpp", "--"],
+    "cpp": BAZEL_RUN + ["//benchmark:benchmark_qli", "--", "cpp"],
+    "hybrid": BAZEL_RUN + ["//benchmark:benchmark_qli", "--", "hybrid"],
+    "python": BAZEL_RUN + ["//benchmark:benchmark_qli", "--", "python"],
+}
+
+FUNCTIONS = ["QLi", "QLiSymm"]
+WEIGHTS = [3, 4, 5, 6, 7]
+NUM_POINTS = [6, 8]
+
+
+def workload_key(result):
+    return (result["backend"], result["function"], result["weight"], result["num_points"])
+
+def format_key(key):
+    backend, function, weight, num_points = key
+    workload = f"{function}{weight}({num_points} points)"
+    return f"{backend:<10}  {workload:<22}"
+
+
+def cpu_model():
+    try:
+        with open("/proc/cpuinfo") as f:
+            for line in f:
+                if line.startswith("model name"):
+                    return line.split(":", 1)[1].strip()
+    except OSError:
+        pass
+    return platform.processor()
+
+def git_revision():
+    try:
+        return subprocess.check_output(
+            ["git", "rev-parse", "HEAD"], cwd=REPO_ROOT, text=True, stderr=subprocess.DEVNULL
+        ).strip()
+    except (OSError, subprocess.CalledProcessError):
+        return None
+
+def machine_metadata():
+    return {
+        "hostname": platform.node(),
+        "system": platform.system(),
+        "release": platform.release(),
+        "machine": platform.machine(),
+        "cpu": cpu_model(),
+        "num_cpus": os.cpu_count(),
+        "python": platform.python_version(),
+    }
+
+
+def run_backend(backend, workloads):
+    command = BACKENDS[backend] + workloads
+    print(f"Running {backend}: {' '.join(command)}", file=sys.stderr)
+    output = subprocess.run(command, cwd=REPO_ROOT, check=True, stdout=subprocess.PIPE, text=True).stdout
+    results = []
+    for line in output.splitlines():
+        line = line.strip()
+        if not line.startswith("{"):
+            continue
+        result = json.loads(line)
+        if result.get("unsupported"):
+            continue
+        result["backend"] = backend
+        results.append(result)
+    return results
+
+
+def compare(results, baseline, threshold):
+    baseline_seconds = {workload_key(r): r["seconds"] for r in baseline["results"]}
+    regressions = []
+    for result in results:
+        key = workload_key(result)
+        if key not in baseline_seconds:
+            continue
+        old = baseline_seconds[key]
+        new = result["seconds"]
+        ratio = new / old if old > 0 else float("inf")
+        status = "REGRESSION" if ratio > 1 + threshold else "improved" if ratio < 1 - threshold else ""
+        print(f"{format_key(key)}  {old:10.4f} -> {new:10.4f} s  x{ratio:5.2f}  {status}")
+        if status == "REGRESSION":
+            regressions.append(key)
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--backends", nargs="+", choices=BACKENDS.keys(), default=list(BACKENDS.keys()))
+    parser.add_argument("--functions", nargs="+", choices=FUNCTIONS, default=FUNCTIONS)
+    parser.add_argument("--weights", nargs="+", type=int, default=WEIGHTS)
+    parser.add_argument("--num-points", nargs="+", type=int, default=NUM_POINTS)
+    parser.add_argument("--output", help="file to store results")
+    parser.add_argument("--baseline", help="baseline file to compare against")
+    parser.add_argument("--update-baseline", action="store_true", help="overwrite baseline with the new results")
+    parser.add_argument(
+        "--threshold", type=float, default=0.1,
+        help="relative slowdown that counts as a regression (default: %(default)s)",
+    )
+    args = parser.parse_args()
+
+    workloads = [
+        f"{function}:{weight}:{num_points}"
+        for function in args.functions
+        for num_points in args.num_points
+        for weight in args.weights
+        if weight >= num_points // 2 - 1
+    ]
+    results = []
+    for backend in args.backends:
+        results += run_backend(backend, workloads)
+    report = {
+        "timestamp": datetime.datetime.now(datetime.timezone.utc).isoformat(),
+        "git_revision": git_revision(),
+        "machine": machine_metadata(),
+        "results": results,
+    }
+
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(report, f, indent=2)
+
+    regressions = []
+    if args.baseline and os.path.exists(args.baseline) and not args.update_baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        if baseline["machine"] != report["machine"]:
+            print("Warning: baseline was recorded on a different machine", file=sys.stderr)
+        regressions = compare(results, baseline, args.threshold)
+    elif args.baseline:
+        with open(args.baseline, "w") as f:
+            json.dump(report, f, indent=2)
+        print(f"Baseline written to {args.baseline}", file=sys.stderr)
+    else:
+        for result in results:
+            print(f"{format_key(workload_key(result))}  {result['seconds']:10.4f} s")
+
+    if regressions:
+        print(f"{len(regressions)} regression(s) found", file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,207 @@
+// Microbenchmarks for individual algebra kernels. Unlike `benchmark_qli` and
+// `benchmark_equations`, which time whole computations, these are meant for proving
+// regressions or wins on a specific kernel.
+//
+// Each benchmark reports CPU time and the average number of heap allocations (and bytes)
+// per iteration. Use `--benchmark_format=json` or `--benchmark_out=<file>` for JSON output.
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "benchmark/benchmark.h"
+
+#include "cpp/lib/compression.h"
+#include "cpp/lib/expr_matrix_builder.h"
+#include "cpp/lib/linalg.h"
+#include "cpp/lib/lyndon.h"
+#include "cpp/lib/polylog_gli.h"
+#include "cpp/lib/polylog_qli.h"
+#include "cpp/lib/sequence_iteration.h"
+#include "cpp/lib/shuffle.h"
+
+
+static std::atomic<int64_t> num_allocations = 0;
+static std::atomic<int64_t> num_allocated_bytes = 0;
+
+void* operator new(size_t size) {
+  num_allocations.fetch_add(1, std::memory_order_relaxed);
+  num_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+class AllocationCounter {
+public:
+  AllocationCounter()
+    : allocations_start_(num_allocations.load()), bytes_start_(num_allocated_bytes.load()) {}
+
+  void report(benchmark::State& state) const {
+    state.counters["allocs"] = benchmark::Counter(
+      num_allocations.load() - allocations_start_, benchmark::Counter::kAvgIterations);
+    state.counters["alloc_bytes"] = benchmark::Counter(
+      num_allocated_bytes.load() - bytes_start_, benchmark::Counter::kAvgIterations);
+  }
+
+private:
+  int64_t allocations_start_ = 0;
+  int64_t bytes_start_ = 0;
+};
+
+template<typename F>
+static void run_benchmark(benchmark::State& state, const F& func) {
+  const AllocationCounter counter;
+  for (EACH : state) {
+    benchmark::DoNotOptimize(func());
+  }
+  counter.report(state);
+}
+
+
+using Word = std::vector<int>;
+using WordExpr = BasicLinear<SimpleLinearParam<Word>>;
+
+static Word make_word(int length, int alphabet_size, int seed) {
+  return mapped(range(length), [&](int i) { return (i * 7 + seed) % alphabet_size; });
+}
+
+static DeltaExpr qli_test_expr(int weight, int num_points) {
+  return QLiVec(weight, seq_incl(1, num_points));
+}
+
+// Columns are QLi of all 4- and 6-point subsets of `num_points` points.
+static std::vector<DeltaExpr> qli_space(int weight, int num_points) {
+  std::vector<DeltaExpr> ret;
+  for (int num_args = 4; num_args <= std::min(num_points, 6); num_args += 2) {
+    for (const auto& seq : increasing_sequences(num_points, num_args)) {
+      ret.push_back(to_lyndon_basis(QLiVec(weight, mapped(seq, [](int x) { return x + 1; }))));
+    }
+  }
+  return ret;
+}
+
+
+// Args: word length.
+static void BM_ShuffleProduct(benchmark::State& state) {
+  const int n = state.range(0);
+  const Word u = make_word(n, 4, 0);
+  const Word v = make_word(n, 4, 1);
+  run_benchmark(state, [&]() { return shuffle_product(u, v); });
+}
+BENCHMARK(BM_ShuffleProduct)->DenseRange(2, 8, 2);
+
+// Args: weight.
+static void BM_ToLyndonBasis(benchmark::State& state) {
+  const DeltaExpr expr = qli_test_expr(state.range(0), 6);
+  run_benchmark(state, [&]() { return to_lyndon_basis(expr); });
+}
+BENCHMARK(BM_ToLyndonBasis)->DenseRange(3, 5);
+
+// Args: weight.
+static void BM_NComultiply(benchmark::State& state) {
+  const int w = state.range(0);
+  const DeltaExpr expr = qli_test_expr(w, 6);
+  run_benchmark(state, [&]() { return ncomultiply(expr, {1, w - 1}); });
+}
+BENCHMARK(BM_NComultiply)->DenseRange(3, 5);
+
+// Args: weight of each factor.
+static void BM_TensorProduct(benchmark::State& state) {
+  const int w = state.range(0);
+  const DeltaExpr lhs = qli_test_expr(w, 4);
+  const DeltaExpr rhs = qli_test_expr(w, 6);
+  run_benchmark(state, [&]() { return tensor_product(lhs, rhs); });
+}
+BENCHMARK(BM_TensorProduct)->DenseRange(2, 3);
+
+// Args: word length. Adds together shuffle products with a large overlap in terms.
+static void BM_BasicLinearAdd(benchmark::State& state) {
+  const int n = state.range(0);
+  const std::vector<WordExpr> summands = mapped(range(8), [&](int seed) {
+    return shuffle_product(make_word(n, 3, seed), make_word(n, 3, seed + 1));
+  });
+  run_benchmark(state, [&]() {
+    WordExpr sum;
+    for (const auto& expr : summands) {
+      sum += expr;
+    }
+    return sum;
+  });
+}
+BENCHMARK(BM_BasicLinearAdd)->DenseRange(3, 6);
+
+// Segments are short, like monoms in an expression. About a third of the values don't fit into
+// half a byte.
+static std::vector<std::vector<int>> compression_test_segments(int num_segments) {
+  return mapped(range(num_segments), [](int seed) { return make_word(8, 24, seed); });
+}
+
+// Args: number of segments.
+static void BM_Compressor(benchmark::State& state) {
+  const auto segments = compression_test_segments(state.range(0));
+  run_benchmark(state, [&]() {
+    Compressor compressor;
+    for (const auto& segment : segments) {
+      compressor.push_segment(segment);
+    }
+    return std::move(compressor).result<CompressedBlob<void>>();
+  });
+}
+BENCHMARK(BM_Compressor)->RangeMultiplier(8)->Range(1, 512);
+
+// Args: number of segments.
+static void BM_Decompressor(benchmark::State& state) {
+  Compressor compressor;
+  for (const auto& segment : compression_test_segments(state.range(0))) {
+    compressor.push_segment(segment);
+  }
+  const auto compressed = std::move(compressor).result<CompressedBlob<void>>();
+  run_benchmark(state, [&]() {
+    Decompressor decompressor(compressed);
+    int total_size = 0;
+    while (!decompressor.done()) {
+      total_size += decompressor.pop_segment().size();
+    }
+    return total_size;
+  });
+}
+BENCHMARK(BM_Decompressor)->RangeMultiplier(8)->Range(1, 512);
+
+// Args: number of points.
+static void BM_ExprVectorMatrixBuilder(benchmark::State& state) {
+  const auto space = qli_space(3, state.range(0));
+  run_benchmark(state, [&]() {
+    ExprVectorMatrixBuilder<DeltaExpr> builder;
+    for (const auto& expr : space) {
+      builder.add_expr({expr});
+    }
+    return builder.make_matrix();
+  });
+}
+BENCHMARK(BM_ExprVectorMatrixBuilder)->DenseRange(6, 8);
+
+// Args: number of points.
+static void BM_MatrixRank(benchmark::State& state) {
+  ExprVectorMatrixBuilder<DeltaExpr> builder;
+  for (const auto& expr : qli_space(3, state.range(0))) {
+    builder.add_expr({expr});
+  }
+  const CompressedMatrix matrix = builder.make_matrix();
+  run_benchmark(state, [&]() { return matrix_rank(matrix); });
+}
+// Rank is computed in parallel, so report CPU time of all threads rather than of the main one.
+BENCHMARK(BM_MatrixRank)->DenseRange(6, 8)->MeasureProcessCPUTime();
+
+// Args: weight.
+static void BM_GLiVec(benchmark::State& state) {
+  const int w = state.range(0);
+  run_benchmark(state, [&]() { return GLiVec(w, seq_incl(1, 6)); });
+}
+BENCHMARK(BM_GLiVec)->DenseRange(2, 4);
+
+
+BENCHMARK_MAIN();
@@ -0,0 +1 @@
+bazel run -c opt --config=clang :benchmark_kernels_cpp -- "$@"
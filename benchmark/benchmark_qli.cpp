@@ -1,15 +1,77 @@
+// Usage:
+//   benchmark_qli_cpp
+//     Prints "(weight, seconds)" for QLi of weights 4..7 on 8 points.
+//   benchmark_qli_cpp <function>:<weight>:<num_points> ...
+//     Prints a JSON line per workload. Supported functions: QLi, QLiSymm.
+//     This is the format expected by `benchmark_harness.py`.
+
 #include <chrono>
 #include <iomanip>
 #include <iostream>
 
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+
 #include "cpp/lib/polylog_qli.h"
 
 
+// Runs the function at least once and until a second has passed, but no more than 20 times.
+// Clears QLi cache before each iteration, otherwise all iterations but the first would be
+// trivial.
+template<typename F>
+static std::pair<int, double> time_per_iteration(const F& func) {
+  constexpr double kMinTotalSec = 1.0;
+  constexpr int kMaxIterations = 20;
+  const auto start = std::chrono::steady_clock::now();
+  int iterations = 0;
+  double total_sec = 0;
+  while (iterations < kMaxIterations && (iterations == 0 || total_sec < kMinTotalSec)) {
+    QLi_clear_cache();
+    func();
+    ++iterations;
+    total_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  return {iterations, total_sec / iterations};
+}
+
+static void run_workload(const std::string& workload) {
+  const std::vector<std::string> parts = absl::StrSplit(workload, ':');
+  int weight = 0;
+  int num_points = 0;
+  CHECK(
+    parts.size() == 3 &&
+    absl::SimpleAtoi(parts[1], &weight) &&
+    absl::SimpleAtoi(parts[2], &num_points)
+  ) << "Bad workload: " << workload;
+  const std::string& function = parts[0];
+  const auto points = seq_incl(1, num_points);
+  std::pair<int, double> result;
+  if (function == "QLi") {
+    result = time_per_iteration([&]() { return QLiVec(weight, points); });
+  } else if (function == "QLiSymm") {
+    result = time_per_iteration([&]() { return QLiSymmVec(weight, points); });
+  } else {
+    FATAL(absl::StrCat("Unsupported function: ", function));
+  }
+  const auto [iterations, time_sec] = result;
+  std::cout << "{\"function\": \"" << function << "\", \"weight\": " << weight
+            << ", \"num_points\": " << num_points << ", \"iterations\": " << iterations
+            << ", \"seconds\": " << std::fixed << std::setprecision(6) << time_sec << "}\n";
+}
+
 int main(int argc, char *argv[]) {
+  if (argc > 1) {
+    for (int i : range(1, argc)) {
+      run_workload(argv[i]);
+    }
+    return 0;
+  }
   for (int w : range(4, 8)) {
     const int iteration = w < 6 ? 20 : 5;
     const auto start = std::chrono::steady_clock::now();
     for (EACH : range(iteration)) {
+      QLi_clear_cache();
       auto expr = QLiVec(w, seq_incl(1, 8));
     }
     const auto finish = std::chrono::steady_clock::now();
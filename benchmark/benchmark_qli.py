@@ -13,8 +13,9 @@
 #       TODO: Figure out how to make this runnable without Bazel.
 #       TODO: Figure out how to make Bazel use PyPy.
 
-import time
 import argparse
+import json
+import time
 
 import pybind.polykit as cpp
 import python.polypy.lib.polylog_qli as python
@@ -70,24 +71,67 @@ def hybrid_QLi(weight, points):
     return qli_impl(weight, tagged_points)
 
 
+def time_per_iteration(func, clear_cache):
+    # Runs at least once and until a second has passed, but no more than 20 times.
+    min_total_sec = 1.0
+    max_iterations = 20
+    start = time.time()
+    iterations = 0
+    total_sec = 0
+    while iterations < max_iterations and (iterations == 0 or total_sec < min_total_sec):
+        clear_cache()
+        func()
+        iterations += 1
+        total_sec = time.time() - start
+    return iterations, total_sec / iterations
+
+
 parser = argparse.ArgumentParser()
 parser.add_argument("implementation", choices=["cpp", "python", "hybrid"])
+parser.add_argument(
+    "workloads", nargs="*", metavar="FUNCTION:WEIGHT:NUM_POINTS",
+    help="If specified, prints a JSON line per workload (format expected by benchmark_harness.py)",
+)
 args = parser.parse_args()
 
 QLi = None
+QLiSymm = None
+# C++ QLi caches sub-expressions across calls; clear the cache to measure actual computation.
+clear_cache = cpp.QLi_clear_cache
 if args.implementation == "cpp":
     QLi = cpp.QLi
+    QLiSymm = cpp.QLiSymm
 elif args.implementation == "python":
     QLi = python.QLi
+    QLiSymm = python.QLiSymm
 elif args.implementation == "hybrid":
     QLi = hybrid_QLi
 
+if args.workloads:
+    functions = {"QLi": QLi, "QLiSymm": QLiSymm}
+    for workload in args.workloads:
+        function, weight, num_points = workload.split(":")
+        weight, num_points = int(weight), int(num_points)
+        func = functions[function]
+        if func is None:
+            print(json.dumps({"function": function, "weight": weight, "num_points": num_points, "unsupported": True}))
+            continue
+        iterations, duration = time_per_iteration(lambda: func(weight, list(range(1, num_points+1))), clear_cache)
+        print(json.dumps({
+            "function": function,
+            "weight": weight,
+            "num_points": num_points,
+            "iterations": iterations,
+            "seconds": duration,
+        }), flush=True)
+    exit()
 
 for weight in range(4, 8):
     iterations = 20 if weight < 6 else 5
     num_points = 8
     start = time.time()
     for _ in range(iterations):
+        clear_cache()
         QLi(weight, list(range(1, num_points+1)))
     duration = (time.time() - start) / iterations
     print(f"({weight}, {duration:.3f})")
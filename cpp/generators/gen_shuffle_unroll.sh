@@ -1 +0,0 @@
-bazel build --config=clang generators:shuffle_unroll && ../bazel-bin/cpp/generators/shuffle_unroll > lib/shuffle_unrolled.h
@@ -1 +0,0 @@
-bazel build --config=clang generators:shuffle_unroll_multi && ../bazel-bin/cpp/generators/shuffle_unroll_multi > lib/shuffle_unrolled_multi.h
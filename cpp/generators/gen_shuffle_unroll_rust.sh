@@ -1 +1 @@
-bazel build --config=clang generators:shuffle_unroll && ../bazel-bin/cpp/generators/shuffle_unroll rust
+bazel build --config=clang generators:shuffle_unroll && ../bazel-bin/cpp/generators/shuffle_unroll
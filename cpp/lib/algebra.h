@@ -131,14 +131,16 @@ outer_product(
     const LinearT& rhs,
     const MonomProdF& monom_key_product,
     const AnnotationsF& = nullptr) {
-  LinearProdT ret;
-  lhs.foreach_key([&](const auto& lhs_key, int lhs_coeff) {
-    rhs.foreach_key([&](const auto& rhs_key, int rhs_coeff) {
-      const auto ret_key = monom_key_product(lhs_key, rhs_key);
-      ASSERT(ret.coeff_for_key(ret_key) == 0);  // outer product must be unique
-      ret.add_to_key(ret_key, lhs_coeff * rhs_coeff);
+  typename LinearProdT::Accumulator acc;
+  acc.reserve(lhs.num_terms() * rhs.num_terms());
+  using CoeffT = typename LinearProdT::CoeffT;
+  lhs.foreach_key([&](const auto& lhs_key, const auto& lhs_coeff) {
+    rhs.foreach_key([&](const auto& rhs_key, const auto& rhs_coeff) {
+      acc.add_to_key(monom_key_product(lhs_key, rhs_key), coeff_mul<CoeffT>(lhs_coeff, rhs_coeff));
     });
   });
+  LinearProdT ret = acc.materialize();
+  ASSERT(ret.num_terms() == lhs.num_terms() * rhs.num_terms());  // outer product must be unique
   return ret;
 }
 template<typename LinearProdT, typename LinearT, typename MonomProdF, typename AnnotationsF>
@@ -198,12 +200,13 @@ outer_product_expanding(
     const LinearT& rhs,
     const MonomProdF& monom_key_product,
     const AnnotationsF& = nullptr) {
+  using CoeffT = typename LinearT::CoeffT;
   LinearT ret;
-  lhs.foreach_key([&](const auto& lhs_key, int lhs_coeff) {
-    rhs.foreach_key([&](const auto& rhs_key, int rhs_coeff) {
+  lhs.foreach_key([&](const auto& lhs_key, const CoeffT& lhs_coeff) {
+    rhs.foreach_key([&](const auto& rhs_key, const CoeffT& rhs_coeff) {
       // TODO: Remove `cast_to` here, push it to the users where necessary.
       const auto& prod = monom_key_product(lhs_key, rhs_key);
-      ret += (lhs_coeff * rhs_coeff) * prod.template cast_to<LinearT>();
+      ret += coeff_mul(lhs_coeff, rhs_coeff) * prod.template cast_to<LinearT>();
     });
   });
   return ret;
@@ -0,0 +1,29 @@
+#include "arena.h"
+
+
+static constexpr size_t kArenaInitialChunkSize = 4096;
+
+// Recycles arena chunks, so that short-lived arenas don't go to the global heap every time.
+static std::pmr::memory_resource* thread_chunk_pool() {
+  thread_local std::pmr::unsynchronized_pool_resource pool(std::pmr::pool_options{
+    .max_blocks_per_chunk = 0,  // implementation default
+    .largest_required_pool_block = 1 << 20,
+  });
+  return &pool;
+}
+
+static thread_local std::pmr::memory_resource* current_arena = nullptr;
+
+ScopedArena::ScopedArena()
+  : resource_(kArenaInitialChunkSize, thread_chunk_pool()),
+    previous_(current_arena) {
+  current_arena = &resource_;
+}
+
+ScopedArena::~ScopedArena() {
+  current_arena = previous_;
+}
+
+std::pmr::memory_resource* ScopedArena::current() {
+  return current_arena ? current_arena : std::pmr::new_delete_resource();
+}
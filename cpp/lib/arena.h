@@ -0,0 +1,62 @@
+// Per-thread monotonic arena for short-lived allocations.
+//
+// `ScopedArena` installs an arena for the current thread until the end of the scope.
+// `ArenaAllocator` draws memory from the arena that was current at the time the allocator was
+// created (or from the global heap if there was none). Deallocation is a no-op: all memory is
+// returned at once when the arena goes out of scope.
+//
+// This is useful for recursive algorithms that create and destroy lots of tiny containers.
+// It is the user's responsibility to make sure that nothing allocated in an arena outlives it,
+// i.e. the final result must be copied to a container with a regular allocator.
+//
+// Arenas can be nested. Nested arena is independent: its memory is released when the inner scope
+// ends. Arena memory chunks are recycled via a per-thread pool, so creating an arena is cheap.
+
+#pragma once
+
+#include <memory_resource>
+
+
+class ScopedArena {
+public:
+  ScopedArena();
+  ~ScopedArena();
+
+  ScopedArena(const ScopedArena&) = delete;
+  ScopedArena& operator=(const ScopedArena&) = delete;
+
+  // Returns the innermost arena of the current thread or the global heap if there is none.
+  static std::pmr::memory_resource* current();
+
+private:
+  std::pmr::monotonic_buffer_resource resource_;
+  std::pmr::memory_resource* previous_ = nullptr;
+};
+
+
+template<typename T>
+class ArenaAllocator {
+public:
+  using value_type = T;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  ArenaAllocator() : resource_(ScopedArena::current()) {}
+  template<typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : resource_(other.resource()) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T* p, size_t n) {
+    resource_->deallocate(p, n * sizeof(T), alignof(T));
+  }
+
+  std::pmr::memory_resource* resource() const { return resource_; }
+
+  template<typename U>
+  bool operator==(const ArenaAllocator<U>& other) const { return resource_ == other.resource(); }
+
+private:
+  std::pmr::memory_resource* resource_;
+};
@@ -1,6 +1,15 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <list>
+#include <mutex>
+
 #include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_format.h"
+
+#include "check.h"
+#include "memory_usage_micro.h"
 
 
 // Workaround a bug. After upgrading to C++23 using an `std::tuple` directly fails to compile with:
@@ -59,28 +68,180 @@ struct OpaqueTuple {
   std::tuple<Args...> tuple;
 };
 
+struct CallCacheStats {
+  int64_t hits = 0;
+  int64_t misses = 0;
+  int64_t evictions = 0;
+  int64_t num_entries = 0;
+  size_t bytes = 0;  // estimated; only tracked while the cache is bounded
+
+  double hit_rate() const {
+    const int64_t total = hits + misses;
+    return total == 0 ? 0. : static_cast<double>(hits) / total;
+  }
+};
+
+inline std::string to_string(const CallCacheStats& stats) {
+  return absl::StrFormat(
+    "%d hits, %d misses (%.1f%% hit rate), %d evictions, %d entries, %d bytes",
+    stats.hits, stats.misses, stats.hit_rate() * 100, stats.evictions, stats.num_entries, stats.bytes
+  );
+}
+
+// Memoizes function results.
+//
 // Sample usage:
 //    return QLi_impl(weight, asc_points);
 // =>
 //    static CallCache<DeltaExpr, int, std::vector<int>> call_cache;
 //    return call_cache.apply(&QLi_impl, weight, asc_points);
 //
+// The cache is thread-safe, so it can be shared between threads. Keys are split into shards by
+// hash, each shard has its own lock. The function is called without holding the lock, so it may
+// use the same cache recursively. The flip side is that two threads asking for the same missing
+// key at the same time would both compute it; the first result to arrive is stored.
+//
+// If `max_bytes` is positive, entries are evicted in order to keep the estimated total size of the
+// cache within the limit. Values that alone exceed the limit are returned but not stored. Each
+// shard evicts its least recently used entries, and shards take turns, so the order of eviction
+// is approximately LRU. Size is estimated using `estimated_ram_usage` for values; only `sizeof` is
+// counted for keys.
 template<typename Value, typename... Args>
 class CallCache {
 public:
+  explicit CallCache(size_t max_bytes = 0) : max_bytes_(max_bytes) {}
+  CallCache(const CallCache&) = delete;
+  CallCache& operator=(const CallCache&) = delete;
+
   template<typename F>
   Value apply(F&& func, Args... args) {
-    const OpaqueTuple<Args...> args_tuple{args...};
-    const auto it = cache_.find(args_tuple);
-    if (it != cache_.end()) {
-      return it->second;
-    } else {
-      Value ret = std::forward<F>(func)(args...);
-      cache_[args_tuple] = ret;
-      return ret;
+    Key key{args...};
+    auto& shard = shards_[shard_index(key)];
+    {
+      std::lock_guard lock(shard.mutex);
+      const auto it = shard.index.find(key);
+      if (it != shard.index.end()) {
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return it->second->value;
+      }
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    Value ret = std::forward<F>(func)(args...);
+    const size_t max_bytes = max_bytes_.load(std::memory_order_relaxed);
+    const size_t entry_bytes = max_bytes > 0 ? entry_size(ret) : 0;
+    if (max_bytes > 0 && entry_bytes > max_bytes) {
+      return ret;  // storing the value would evict everything else
+    }
+    {
+      std::lock_guard lock(shard.mutex);
+      const auto [it, inserted] = shard.index.try_emplace(key);
+      if (!inserted) {
+        return ret;  // computed concurrently by another thread
+      }
+      shard.entries.push_front({std::move(key), ret, entry_bytes});
+      it->second = shard.entries.begin();
+      shard.bytes += entry_bytes;
+      total_bytes_.fetch_add(entry_bytes, std::memory_order_relaxed);
+    }
+    if (max_bytes > 0) {
+      evict();
+    }
+    return ret;
+  }
+
+  // Changes the limit on the estimated cache size; zero means no limit. Entries that were added
+  // while the cache was unbounded are not counted.
+  void set_max_bytes(size_t max_bytes) {
+    max_bytes_.store(max_bytes, std::memory_order_relaxed);
+    evict();
+  }
+
+  CallCacheStats stats() const {
+    CallCacheStats ret;
+    ret.hits = hits_.load(std::memory_order_relaxed);
+    ret.misses = misses_.load(std::memory_order_relaxed);
+    ret.evictions = evictions_.load(std::memory_order_relaxed);
+    for (const auto& shard : shards_) {
+      std::lock_guard lock(shard.mutex);
+      ret.num_entries += shard.index.size();
+    }
+    ret.bytes = total_bytes_.load(std::memory_order_relaxed);
+    return ret;
+  }
+
+  // Drops all cached values. Statistics are preserved.
+  void clear() {
+    for (auto& shard : shards_) {
+      std::lock_guard lock(shard.mutex);
+      shard.index.clear();
+      shard.entries.clear();
+      total_bytes_.fetch_sub(shard.bytes, std::memory_order_relaxed);
+      shard.bytes = 0;
     }
   }
 
 private:
-  absl::flat_hash_map<OpaqueTuple<Args...>, Value> cache_;
+  static constexpr int kShardBits = 6;
+  static constexpr size_t kNumShards = 1 << kShardBits;
+
+  using Key = OpaqueTuple<Args...>;
+
+  struct Entry {
+    Key key;
+    Value value;
+    size_t bytes = 0;
+  };
+  using EntryList = std::list<Entry>;  // from most recently used to least recently used
+
+  struct Shard {
+    mutable std::mutex mutex;
+    EntryList entries;
+    absl::flat_hash_map<Key, typename EntryList::iterator> index;
+    size_t bytes = 0;
+  };
+
+  // Use high bits: low bits are used by `flat_hash_map` itself to look up keys in a group.
+  static int shard_index(const Key& key) {
+    return static_cast<uint64_t>(absl::Hash<Key>{}(key)) >> (64 - kShardBits);
+  }
+
+  static size_t entry_size(const Value& value) {
+    // Key is stored twice: in the list and in the index.
+    constexpr size_t kOverhead = 2 * sizeof(Key) + sizeof(Entry) + 2 * sizeof(void*);
+    return estimated_ram_usage(value).bytes + kOverhead;
+  }
+
+  // Drops least recently used entries until the cache fits into the limit. Takes one entry from
+  // each shard in turn, so that the budget is shared between shards. Locks one shard at a time.
+  void evict() {
+    int num_empty_in_a_row = 0;
+    while (num_empty_in_a_row < kNumShards) {
+      const size_t max_bytes = max_bytes_.load(std::memory_order_relaxed);
+      if (max_bytes == 0 || total_bytes_.load(std::memory_order_relaxed) <= max_bytes) {
+        return;
+      }
+      auto& shard = shards_[evict_cursor_.fetch_add(1, std::memory_order_relaxed) % kNumShards];
+      std::lock_guard lock(shard.mutex);
+      if (shard.entries.empty()) {
+        ++num_empty_in_a_row;
+        continue;
+      }
+      num_empty_in_a_row = 0;
+      const Entry& victim = shard.entries.back();
+      shard.bytes -= victim.bytes;
+      total_bytes_.fetch_sub(victim.bytes, std::memory_order_relaxed);
+      shard.index.erase(victim.key);
+      shard.entries.pop_back();
+      evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  std::atomic<size_t> max_bytes_;
+  std::atomic<size_t> total_bytes_ = 0;
+  std::atomic<size_t> evict_cursor_ = 0;
+  std::array<Shard, kNumShards> shards_;
+  std::atomic<int64_t> hits_ = 0;
+  std::atomic<int64_t> misses_ = 0;
+  std::atomic<int64_t> evictions_ = 0;
 };
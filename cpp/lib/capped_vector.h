@@ -1,8 +1,11 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <compare>
 
 #include "check.h"
+#include "memory_usage_micro.h"
 
 
 // Optimization potential: properly use in-place new/delete instead of filling with T().
@@ -136,7 +139,11 @@ public:
     return data_.begin() + size_;
   }
 
-  bool operator< (const CappedVector& other) const { return absl::c_lexicographical_compare(*this, other); }
+  std::weak_ordering operator<=>(const CappedVector& other) const {
+    return std::lexicographical_compare_three_way(
+      begin(), end(), other.begin(), other.end(), std::compare_weak_order_fallback
+    );
+  }
   bool operator==(const CappedVector& other) const { return absl::c_equal(*this, other); }
 
   template <typename H>
@@ -155,3 +162,8 @@ template<typename T, uint8_t N>
 std::string dump_to_string_impl(const CappedVector<T, N>& v) {
   return internal::dump_vector_like_to_string(v);
 }
+
+template<typename T, uint8_t N>
+MemoryUsage estimated_heap_usage(const CappedVector<T, N>& v) {
+  return sum(v, [](const auto& e) { return estimated_heap_usage(e); });
+}
@@ -56,6 +56,8 @@
 
 #pragma once
 
+#include <deque>
+
 #include "algebra.h"
 #include "lyndon.h"
 #include "sorting.h"
@@ -171,14 +173,15 @@ CoExprT sort_coproduct_parts(const CoExprT& expr) {
   if constexpr (CoExprT::Param::coproduct_is_iterated) {
     return to_lyndon_basis(expr);
   } else {
+    using CoParamT = typename CoExprT::Param;
     CoExprT sorted_expr;
-    for (const auto& [term_ref, coeff] : key_view(expr)) {
-      auto term = term_ref;
+    for (const auto& [key, coeff] : key_view(expr)) {
+      auto term = CoParamT::key_to_vector(key);
       // Note: the comparator is fixed, because filtering by form in `ncomultiply_impl`
       // assumes shorter element go first.
       const int sign = sort_with_sign(term, DISAMBIGUATE(compare_length_first));
       if (all_unique_sorted(term)) {
-        sorted_expr.add_to_key(term, sign * coeff);
+        sorted_expr.add_to_key(CoParamT::vector_to_key(std::move(term)), sign * coeff);
       }
     }
     return sorted_expr.copy_annotations(expr);
@@ -208,6 +211,49 @@ auto coproduct_vec(const std::vector<CoExprT>& coexpr) {
     return ret;  // `sort_coproduct_parts` might not compile here, thus `if constexpr`
   }
 }
+
+// Lyndon basis expansion of a single coproduct part, as a list of (key, coeff) pairs.
+template<typename PartParamT, typename CoeffT>
+using PartExpansion = std::vector<std::pair<typename PartParamT::StorageT, CoeffT>>;
+
+template<typename PartParamT, typename CoeffT>
+PartExpansion<PartParamT, CoeffT> part_lyndon_expansion(typename PartParamT::VectorT part) {
+  using PartExprT = BasicLinear<PartParamT>;
+  PartExpansion<PartParamT, CoeffT> ret;
+  to_lyndon_basis(PartExprT::single_key(PartParamT::vector_to_key(std::move(part))))
+    .foreach_key([&](const auto& key, const auto& coeff) {
+      ret.push_back({key, CoeffT(coeff)});
+    });
+  return ret;
+}
+
+// Calls `func(term, coeff)` for each term of the outer product of part expansions, where `term`
+// is a coexpression in vector form with one part taken from each factor.
+template<typename CoVectorT, typename ExpansionT, typename F>
+void foreach_part_combination(const std::vector<const ExpansionT*>& factors, const F& func) {
+  using CoeffT = typename ExpansionT::value_type::second_type;
+  if (absl::c_any_of(factors, [](const ExpansionT* f) { return f->empty(); })) {
+    return;
+  }
+  std::vector<int> indices(factors.size(), 0);
+  while (true) {
+    CoeffT coeff = 1;
+    CoVectorT term = mapped_to<CoVectorT>(range(factors.size()), [&](int i) {
+      const auto& [part_key, part_coeff] = (*factors[i])[indices[i]];
+      coeff = coeff_mul(coeff, part_coeff);
+      return part_key;
+    });
+    func(std::move(term), coeff);
+    int k = factors.size() - 1;
+    while (k >= 0 && ++indices[k] == factors[k]->size()) {
+      indices[k] = 0;
+      --k;
+    }
+    if (k < 0) {
+      break;
+    }
+  }
+}
 }  // namespace internal
 
 // Fixes the order of multiples between parts and within parts in a manually constructed co-expression.
@@ -274,45 +320,57 @@ auto icomultiply(const ExprT& expr, std::vector<int> form) {
   absl::c_sort(form);  // avoid unnecessary work in `sort_coproduct_parts`
 
   using MonomT = typename ExprT::StorageT;
-  // Optimization potential: remove conversion of vector form to key (here) and back
-  // (inside to_lyndon_basis inside coproduct). Idea: convert to Lyndon basis here
-  // and add a compile-time flag to `icoproduct` saying that this is no longer required;
-  // note that in this case it might be better to convert the entire expression first
-  // (see above).
-  static auto make_copart = [](auto span) {
-    return ExprT::single_key(
-      ExprT::Param::vector_to_key(typename ExprT::Param::VectorT(span.begin(), span.end()))
-    );
+  using VectorT = typename ExprT::Param::VectorT;
+  using PartParam = typename CoExprT::Param::PartExprParam;
+  using CoVectorT = typename CoExprT::Param::VectorT;
+  using CoeffT = linear_coeff_t<typename CoExprT::Param>;
+  using PartExpansionT = internal::PartExpansion<PartParam, CoeffT>;
+
+  // Parts are converted to Lyndon basis here rather than inside `icoproduct`, so that each
+  // distinct part is converted only once and there is no round-trip through single-term
+  // expressions. Coproduct terms are then assembled from normalized parts directly, and parts
+  // as wholes are normalized once for the entire result (this is linear, so it commutes with
+  // summation).
+  // Note. The deque is used for pointer stability.
+  absl::flat_hash_map<VectorT, int> part_indices;
+  std::deque<PartExpansionT> part_expansions;
+  const auto get_part = [&](absl::Span<const typename VectorT::value_type> span) {
+    VectorT part(span.begin(), span.end());
+    const auto [it, inserted] = part_indices.try_emplace(part, part_expansions.size());
+    if (inserted) {
+      part_expansions.push_back(internal::part_lyndon_expansion<PartParam, CoeffT>(std::move(part)));
+    }
+    return &part_expansions[it->second];
   };
   CoExprT ret;
-  expr.foreach_key([&](const MonomT& monom, int coeff) {
+  const auto add_coproduct = [&](const std::vector<const PartExpansionT*>& parts, const CoeffT& coeff) {
+    internal::foreach_part_combination<CoVectorT>(parts, [&](CoVectorT term, const CoeffT& term_coeff) {
+      ret.add_to_key(CoExprT::Param::vector_to_key(std::move(term)), coeff_mul(coeff, term_coeff));
+    });
+  };
+  to_lyndon_basis(expr).foreach_key([&](const MonomT& monom, const CoeffT& coeff) {
     const auto& monom_vec = ExprT::Param::key_to_vector(monom);
     CHECK_EQ(monom_vec.size(), weight);
     const auto span = absl::MakeConstSpan(monom_vec);
     if (form.size() == 2) {
       const int split = form[0];
-      ret += coeff * icoproduct(
-        make_copart(span.subspan(0, split)),
-        make_copart(span.subspan(split))
-      );
+      add_coproduct({get_part(span.subspan(0, split)), get_part(span.subspan(split))}, coeff);
       if (form[0] != form[1]) {
         const int split = form[1];
-        ret -= coeff * icoproduct(
-          make_copart(span.subspan(split)),
-          make_copart(span.subspan(0, split))
-        );
+        add_coproduct({get_part(span.subspan(split)), get_part(span.subspan(0, split))}, coeff_neg(coeff));
       }
     } else {
-      std::vector<ExprT> parts;
+      std::vector<const PartExpansionT*> parts;
       int part_begin = 0;
       for (const int part_weight : form) {
-        parts.push_back(make_copart(span.subspan(part_begin, part_weight)));
+        parts.push_back(get_part(span.subspan(part_begin, part_weight)));
         part_begin += part_weight;
       }
       CHECK_EQ(part_begin, span.size());
-      ret += coeff * icoproduct_vec(parts);
+      add_coproduct(parts, coeff);
     }
   });
+  ret = internal::sort_coproduct_parts(ret);
   return ret.copy_annotations_mapped(
     expr, [](const std::string& annotation) {
       return fmt::comult() + annotation;
@@ -321,6 +379,88 @@ auto icomultiply(const ExprT& expr, std::vector<int> form) {
 }
 
 namespace internal {
+// Normal comultiplication of a normal coexpression, computed directly in key space.
+// Compared to building `ncoproduct_vec` for every cut point:
+//   * cuts that don't match `form` are skipped before doing any work;
+//   * Lyndon expansion of each distinct part is computed once per call, like in `icomultiply`;
+//   * there are no intermediate expressions, the parts are combined and sorted in place.
+template<typename CoExprT>
+CoExprT ncomultiply_key_space(const CoExprT& coexpr, const std::vector<int>& form) {
+  static_assert(CoExprT::Param::coproduct_is_lie_algebra && !CoExprT::Param::coproduct_is_iterated);
+  using PartParam = typename CoExprT::Param::PartExprParam;
+  using PartKeyT = typename PartParam::StorageT;
+  using PartVectorT = typename PartParam::VectorT;
+  using CoMonomT = typename CoExprT::StorageT;
+  using CoVectorT = typename CoExprT::Param::VectorT;
+  using CoeffT = linear_coeff_t<typename CoExprT::Param>;
+  using PartExpansionT = PartExpansion<PartParam, CoeffT>;
+  const std::vector<int> sorted_form = sorted(form);
+
+  // Note. The deque is used for pointer stability.
+  absl::flat_hash_map<PartVectorT, int> part_indices;
+  std::deque<PartExpansionT> part_expansions;
+  const auto get_part = [&](auto begin, auto end) {
+    PartVectorT part(begin, end);
+    const auto [it, inserted] = part_indices.try_emplace(part, part_expansions.size());
+    if (inserted) {
+      part_expansions.push_back(part_lyndon_expansion<PartParam, CoeffT>(std::move(part)));
+    }
+    return &part_expansions[it->second];
+  };
+
+  typename CoExprT::Basic::Accumulator acc;
+  coexpr.foreach_key([&](const CoMonomT& term, const CoeffT& coeff) {
+    const CoVectorT term_vector = CoExprT::Param::key_to_vector(term);
+    const int num_parts = term_vector.size();
+    const auto part_vectors = mapped(term_vector, [](const PartKeyT& key) -> PartVectorT {
+      return PartParam::key_to_vector(key);
+    });
+    for (const int i_cut_part : range(num_parts)) {
+      const PartVectorT& cut_part = part_vectors[i_cut_part];
+      const int cut_part_size = cut_part.size();
+      for (const int cut_pos : range(1, cut_part_size)) {
+        if (!form.empty()) {
+          std::vector<int> sizes;
+          for (const int i_part : range(num_parts)) {
+            if (i_part == i_cut_part) {
+              sizes.push_back(cut_pos);
+              sizes.push_back(cut_part_size - cut_pos);
+            } else {
+              sizes.push_back(part_vectors[i_part].size());
+            }
+          }
+          absl::c_sort(sizes);
+          if (sizes != sorted_form) {
+            continue;
+          }
+        }
+        std::vector<const PartExpansionT*> factors;
+        for (const int i_part : range(num_parts)) {
+          if (i_part == i_cut_part) {
+            factors.push_back(get_part(cut_part.begin(), cut_part.begin() + cut_pos));
+            factors.push_back(get_part(cut_part.begin() + cut_pos, cut_part.end()));
+          } else {
+            const PartVectorT& part = part_vectors[i_part];
+            factors.push_back(get_part(part.begin(), part.end()));
+          }
+        }
+        const int cut_sign = neg_one_pow(i_cut_part);
+        foreach_part_combination<CoVectorT>(factors, [&](CoVectorT new_term, const CoeffT& new_coeff) {
+          // Same as in `sort_coproduct_parts`.
+          const int sort_sign = sort_with_sign(new_term, DISAMBIGUATE(compare_length_first));
+          if (all_unique_sorted(new_term)) {
+            acc.add_to_key(
+              CoExprT::Param::vector_to_key(std::move(new_term)),
+              coeff_mul(coeff, coeff_mul(new_coeff, CoeffT(cut_sign * sort_sign)))
+            );
+          }
+        });
+      }
+    }
+  });
+  return CoExprT(acc.materialize());
+}
+
 template<typename CoExprT>
 auto ncomultiply_impl(const CoExprT& coexpr, std::vector<int> form) {
   if (coexpr.is_zero()) {
@@ -334,33 +474,37 @@ auto ncomultiply_impl(const CoExprT& coexpr, std::vector<int> form) {
     CHECK(form.size() == coexpr.element().first.size() + 1) << dump_to_string(form);
   }
 
-  using ExprT = Linear<typename CoExprT::Param::PartExprParam>;
-  // using MonomT = typename CoExprT::StorageT;
-  using ObjectT = typename CoExprT::ObjectT;
   CoExprT ret;
-  // Optimization potential: operate in key space
-  // Optimization potential: smarter cut point iteration if form is given.
-  coexpr.foreach([&](const ObjectT& parts, int coeff) {
-    // const ObjectT parts = CoExprT::Param::key_to_vector(monom);
-    for (int i_cut_part : range(parts.size())) {
-      const auto& cut_part = parts[i_cut_part];
-      for (int cut_pos : range(1, cut_part.size())) {
-        std::vector<ExprT> new_parts;
-        for (int i_part : range(parts.size())) {
-          if (i_part == i_cut_part) {
-            new_parts.push_back(ExprT::single(slice(cut_part, 0, cut_pos)));
-            new_parts.push_back(ExprT::single(slice(cut_part, cut_pos)));
-          } else {
-            new_parts.push_back(ExprT::single(parts[i_part]));
+  if constexpr (CoExprT::Param::coproduct_is_lie_algebra && !CoExprT::Param::coproduct_is_iterated) {
+    ret = ncomultiply_key_space(coexpr, form);
+  } else {
+    using ExprT = Linear<typename CoExprT::Param::PartExprParam>;
+    using ObjectT = typename CoExprT::ObjectT;
+    typename CoExprT::Basic::Accumulator acc;
+    using CoeffT = linear_coeff_t<typename CoExprT::Param>;
+    coexpr.foreach([&](const ObjectT& parts, const CoeffT& coeff) {
+      for (int i_cut_part : range(parts.size())) {
+        const auto& cut_part = parts[i_cut_part];
+        for (int cut_pos : range(1, cut_part.size())) {
+          std::vector<ExprT> new_parts;
+          for (int i_part : range(parts.size())) {
+            if (i_part == i_cut_part) {
+              new_parts.push_back(ExprT::single(slice(cut_part, 0, cut_pos)));
+              new_parts.push_back(ExprT::single(slice(cut_part, cut_pos)));
+            } else {
+              new_parts.push_back(ExprT::single(parts[i_part]));
+            }
           }
+          const int sign = neg_one_pow(i_cut_part);
+          // The parts are not annotated, so the product isn't either.
+          acc.add_expr(ncoproduct_vec(new_parts).main(), coeff_mul(coeff, CoeffT(sign)));
         }
-        const int sign = neg_one_pow(i_cut_part);
-        ret += sign * coeff * ncoproduct_vec(new_parts);
       }
+    });
+    ret = CoExprT(acc.materialize());
+    if (!form.empty()) {
+      ret = keep_coexpr_form(ret, form);
     }
-  });
-  if (!form.empty()) {
-    ret = keep_coexpr_form(ret, form);
   }
   return ret.copy_annotations_mapped(
     coexpr, [](const std::string& annotation) {
@@ -0,0 +1,231 @@
+// Coefficient types for linear expressions.
+//
+// A linear param can choose the coefficient type by defining `using CoeffT = ...;`.
+// The default is `int`. Supported types:
+//   * `int`, `int64_t`, `__int128`. Arithmetic is checked for overflow when assertions are
+//     enabled (see ENABLE_ASSERTIONS in check.h), otherwise it wraps around silently (modulo
+//     2^N, without undefined behavior).
+//   * `ModP<p>`: integers modulo a prime p < 2^31. Cannot overflow. Division is exact as long as
+//     the divisor is not a multiple of p. `ModPCoeff` uses the same prime as modular rank, so
+//     expressions can be fed to `RankBackend::modular` without losing information.
+//
+// All operations on coefficients go through the `coeff_*` functions below.
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <type_traits>
+
+#include "absl/strings/str_cat.h"
+
+#include "check.h"
+#include "memory_usage_micro.h"
+#include "util.h"
+
+
+template<uint32_t P>
+class ModP {
+public:
+  static_assert(P > 1 && P < (1u << 31));
+  static constexpr uint32_t kModulus = P;
+
+  constexpr ModP() {}
+  constexpr ModP(int64_t value) : value_(reduce(value)) {}
+
+  constexpr uint32_t value() const { return value_; }
+  // Representative in (-p/2, p/2].
+  constexpr int64_t symmetric_value() const {
+    return value_ > P / 2 ? static_cast<int64_t>(value_) - P : value_;
+  }
+
+  constexpr ModP operator-() const { return ModP(value_ == 0 ? 0 : P - value_, kRaw); }
+  constexpr ModP operator+(ModP other) const {
+    const uint32_t sum = value_ + other.value_;  // no overflow since P < 2^31
+    return ModP(sum >= P ? sum - P : sum, kRaw);
+  }
+  constexpr ModP operator-(ModP other) const { return *this + (-other); }
+  constexpr ModP operator*(ModP other) const {
+    return ModP(static_cast<uint64_t>(value_) * other.value_ % P, kRaw);
+  }
+  ModP& operator+=(ModP other) { return *this = *this + other; }
+  ModP& operator-=(ModP other) { return *this = *this - other; }
+  ModP& operator*=(ModP other) { return *this = *this * other; }
+
+  // Multiplicative inverse via Fermat's little theorem.
+  ModP inverse() const {
+    CHECK(value_ != 0) << "Division by zero modulo " << P;
+    ModP ret = 1;
+    ModP base = *this;
+    for (uint32_t e = P - 2; e > 0; e /= 2) {
+      if (e % 2 == 1) {
+        ret *= base;
+      }
+      base *= base;
+    }
+    return ret;
+  }
+
+  constexpr bool operator==(const ModP&) const = default;
+
+  template<typename H>
+  friend H AbslHashValue(H h, const ModP& v) {
+    return H::combine(std::move(h), v.value_);
+  }
+
+private:
+  struct RawTag {};
+  static constexpr RawTag kRaw{};
+  constexpr ModP(uint32_t value, RawTag) : value_(value) {}
+
+  static constexpr uint32_t reduce(int64_t value) {
+    const int64_t r = value % static_cast<int64_t>(P);
+    return r < 0 ? r + P : r;
+  }
+
+  uint32_t value_ = 0;
+};
+
+using ModPCoeff = ModP<2147483647u>;  // == kRankPrimes[0], checked in linalg_modular.h
+
+template<typename T>
+struct is_mod_p : std::false_type {};
+template<uint32_t P>
+struct is_mod_p<ModP<P>> : std::true_type {};
+template<typename T>
+inline constexpr bool is_mod_p_v = is_mod_p<T>::value;
+
+template<typename T>
+inline constexpr bool is_integer_coeff_v =
+  std::is_same_v<T, int> || std::is_same_v<T, int64_t> || std::is_same_v<T, __int128>;
+
+
+// Unsigned counterpart of an integer coefficient type. Signed overflow is undefined behavior, so
+// unchecked arithmetic is done in the unsigned type, which wraps around.
+template<typename T>
+using coeff_unsigned_t = typename std::conditional_t<
+  std::is_same_v<T, __int128>, std::type_identity<unsigned __int128>, std::make_unsigned<T>
+>::type;
+
+template<typename T>
+T coeff_add(const T& a, const T& b) {
+  if constexpr (is_integer_coeff_v<T>) {
+#if ENABLE_ASSERTIONS
+    T ret;
+    CHECK(!__builtin_add_overflow(a, b, &ret)) << "Coefficient overflow in addition";
+    return ret;
+#else
+    using U = coeff_unsigned_t<T>;
+    return static_cast<T>(static_cast<U>(a) + static_cast<U>(b));
+#endif
+  } else {
+    return a + b;
+  }
+}
+
+template<typename T>
+T coeff_sub(const T& a, const T& b) {
+  if constexpr (is_integer_coeff_v<T>) {
+#if ENABLE_ASSERTIONS
+    T ret;
+    CHECK(!__builtin_sub_overflow(a, b, &ret)) << "Coefficient overflow in subtraction";
+    return ret;
+#else
+    using U = coeff_unsigned_t<T>;
+    return static_cast<T>(static_cast<U>(a) - static_cast<U>(b));
+#endif
+  } else {
+    return a - b;
+  }
+}
+
+template<typename T>
+T coeff_mul(const T& a, const T& b) {
+  if constexpr (is_integer_coeff_v<T>) {
+#if ENABLE_ASSERTIONS
+    T ret;
+    CHECK(!__builtin_mul_overflow(a, b, &ret)) << "Coefficient overflow in multiplication";
+    return ret;
+#else
+    using U = coeff_unsigned_t<T>;
+    return static_cast<T>(static_cast<U>(a) * static_cast<U>(b));
+#endif
+  } else {
+    return a * b;
+  }
+}
+
+template<typename T>
+T coeff_neg(const T& a) {
+  return coeff_sub(T(0), a);
+}
+
+// Exact division. Throws `IntegerDivisionError` if the result is not an integer.
+template<typename T>
+T coeff_div(const T& a, const T& b) {
+  if constexpr (is_mod_p_v<T>) {
+    return a * b.inverse();
+  } else {
+    CHECK(b != 0);
+    if (a % b != 0) {
+      throw IntegerDivisionError();
+    }
+    return a / b;
+  }
+}
+
+// For `ModP` uses the symmetric representative.
+template<typename T>
+auto coeff_abs(const T& a) {
+  if constexpr (is_mod_p_v<T>) {
+    const int64_t v = a.symmetric_value();
+    return v < 0 ? -v : v;
+  } else {
+    return a < 0 ? coeff_neg(a) : a;
+  }
+}
+
+// Returns the coefficient as a regular integer if it fits (for `ModP` uses the symmetric
+// representative).
+template<typename IntT, typename T>
+std::optional<IntT> coeff_to_int(const T& a) {
+  if constexpr (is_mod_p_v<T>) {
+    return coeff_to_int<IntT>(a.symmetric_value());
+  } else {
+    if (a < std::numeric_limits<IntT>::min() || a > std::numeric_limits<IntT>::max()) {
+      return std::nullopt;
+    }
+    return static_cast<IntT>(a);
+  }
+}
+
+// Converts the coefficient to `int64_t` for output. Dies if it doesn't fit.
+template<typename T>
+int64_t coeff_for_printing(const T& a) {
+  const auto ret = coeff_to_int<int64_t>(a);
+  CHECK(ret.has_value()) << "Coefficient is too large to print";
+  return *ret;
+}
+
+// Converts the coefficient to a matrix element (matrices store `int`). Dies if it doesn't fit.
+// For `ModP` this is the symmetric representative, so ranking such a matrix modulo the same
+// prime (e.g. `ModPCoeff` with `RankBackend::modular`) doesn't lose information.
+template<typename T>
+int coeff_to_matrix_element(const T& a) {
+  const auto ret = coeff_to_int<int>(a);
+  CHECK(ret.has_value()) << "Coefficient is too large for a matrix element";
+  return *ret;
+}
+
+
+template<uint32_t P>
+std::string to_string(const ModP<P>& v) {
+  return absl::StrCat(v.value(), " (mod ", P, ")");
+}
+
+template<uint32_t P>
+MemoryUsage estimated_heap_usage(const ModP<P>&) {
+  return {0, 0};
+}
@@ -238,17 +238,24 @@ struct DeltaICoExprParam {
   using ObjectT = std::vector<std::vector<Delta>>;
 #if DISABLE_PACKING
   IDENTITY_STORAGE_FORM
+  IDENTITY_VECTOR_FORM
 #else
   using PartStorageT = DeltaExprParam::StorageT;
-  using StorageT = CopartVector<PartStorageT>;
+  using StorageT = FlatCopartVector<DeltaStorage>;
+  using VectorT = CopartVector<PartStorageT>;
   static StorageT object_to_key(const ObjectT& obj) {
-    return mapped_to<StorageT>(obj, DeltaExprParam::object_to_key);
+    return vector_to_key(mapped_to<VectorT>(obj, DeltaExprParam::object_to_key));
   }
   static ObjectT key_to_object(const StorageT& key) {
-    return mapped(key, DeltaExprParam::key_to_object);
+    return mapped(key_to_vector(key), DeltaExprParam::key_to_object);
+  }
+  static VectorT key_to_vector(const StorageT& key) {
+    return key.template to_parts<VectorT>();
+  }
+  static StorageT vector_to_key(const VectorT& vec) {
+    return StorageT::from_parts(vec);
   }
 #endif
-  IDENTITY_VECTOR_FORM
   LYNDON_COMPARE_LENGTH_FIRST
   CO_DERIVE_WEIGHT_AND_UNIFORMITY_MARKER
   static std::string object_to_string(const ObjectT& obj) {
@@ -275,7 +282,7 @@ struct DeltaACoExprParam : DeltaICoExprParam {
 };
 
 static_assert(DeltaExprParam::StorageT::kCanInline);
-// static_assert(DeltaNCoExprParam::StorageT::kCanInline);
+static_assert(DeltaNCoExprParam::StorageT::kCanInline);
 }  // namespace internal
 
 
@@ -1,6 +1,11 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <mutex>
+
 #include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
 
 
 template<typename T>
@@ -24,3 +29,39 @@ public:
 private:
   absl::flat_hash_map<T, int> index_map_;
 };
+
+
+// Thread-safe version of `Enumerator`. Keys are split into shards by hash, each shard has its own
+// lock, so threads rarely wait for each other. Indices are dense, i.e. they form [0, size()), but
+// when keys are added concurrently the order is not deterministic.
+template<typename T>
+class ConcurrentEnumerator {
+public:
+  int index(const T& key) {
+    auto& shard = shards_[shard_index(key)];
+    std::lock_guard lock(shard.mutex);
+    const auto [it, inserted] = shard.index_map.try_emplace(key, 0);
+    if (inserted) {
+      it->second = next_index_++;
+    }
+    return it->second;
+  }
+
+  int size() const { return next_index_; }
+
+private:
+  static constexpr int kShardBits = 6;
+
+  struct Shard {
+    std::mutex mutex;
+    absl::flat_hash_map<T, int> index_map;
+  };
+
+  // Use high bits: low bits are used by `flat_hash_map` itself to look up keys in a group.
+  static int shard_index(const T& key) {
+    return static_cast<uint64_t>(absl::Hash<T>{}(key)) >> (64 - kShardBits);
+  }
+
+  std::array<Shard, (1 << kShardBits)> shards_;
+  std::atomic<int> next_index_ = 0;
+};
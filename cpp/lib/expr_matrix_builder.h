@@ -2,57 +2,106 @@
 
 #include "absl/container/flat_hash_set.h"
 
+#include "coeff.h"
 #include "compact_variant.h"
 #include "enumerator.h"
 #include "linalg.h"
+#include "parallel_util.h"
+#include "spilled_matrix.h"
 #include "util.h"
 
 
 namespace internal {
 using SparseElement = std::pair<int, int>;  // (row/col, value)
 
-Matrix make_matrix(
+CompressedMatrix make_matrix(
   const std::vector<std::vector<SparseElement>>& sparse_cols, int num_rows
 );
+
+// Lists monoms of expressions that form one matrix column, as (key, coeff) pairs. Expressions
+// are given either as `ExprTs...`, or as `std::tuple<ExprTs...>`, or as `std::vector<ExprT>`.
+template<typename... ExprTs>
+struct ExprMonoms {
+  using KeyT = CompactVariant<typename ExprTs::ObjectT...>;
+
+  template<typename F>
+  static void for_each(const ExprTs&... expressions, const F& func) {
+    for_each_impl<0>(func, expressions...);
+  }
+
+private:
+  template<std::size_t Idx, typename F, typename Head, typename... Tail>
+  static void for_each_impl(const F& func, const Head& head, const Tail&... tail) {
+    for (const auto& [term, coeff] : head) {
+      func(KeyT{std::in_place_index<Idx>, term}, coeff);
+    }
+    for_each_impl<Idx + 1>(func, tail...);
+  }
+  template<std::size_t Idx, typename F>
+  static void for_each_impl(const F&) {}
+};
+template<typename... ExprTs>
+struct ExprMonoms<std::tuple<ExprTs...>> {
+  using KeyT = typename ExprMonoms<ExprTs...>::KeyT;
+
+  template<typename F>
+  static void for_each(const std::tuple<ExprTs...>& expressions, const F& func) {
+    std::apply(
+      [&](const auto&... args) { ExprMonoms<ExprTs...>::for_each(args..., func); },
+      expressions
+    );
+  }
+};
+template<typename ExprT>
+struct ExprMonoms<std::vector<ExprT>> {
+  using KeyT = std::pair<int, typename ExprT::ObjectT>;
+
+  template<typename F>
+  static void for_each(const std::vector<ExprT>& expressions, const F& func) {
+    for (const int expr_idx : range(expressions.size())) {
+      for (const auto& [term, coeff] : expressions[expr_idx]) {
+        func(KeyT{expr_idx, term}, coeff);
+      }
+    }
+  }
+};
 }  // namespace internal
 
 
 template<typename... ExprTs>
 class ExprTupleMatrixBuilder {
 public:
+  using SparseElement = internal::SparseElement;
+
   void add_expr(const std::tuple<ExprTs...>& expressions) {
+    sparse_cols_.push_back(make_col(expressions));
+  }
+  void add_expr(const ExprTs&... expressions) {
+    sparse_cols_.push_back(make_col(expressions...));
+  }
+
+  // Converts expressions to a column without adding it to the matrix. Note that this
+  // still registers new monoms (rows).
+  std::vector<SparseElement> make_col(const std::tuple<ExprTs...>& expressions) {
     return std::apply(
-      [this](const auto&... args) { return add_expr_impl(args...); },
+      [this](const auto&... args) { return make_col(args...); },
       expressions
     );
   }
-  void add_expr(const ExprTs&... expressions) {
-    return add_expr_impl(expressions...);
+  std::vector<SparseElement> make_col(const ExprTs&... expressions) {
+    std::vector<SparseElement> col;
+    internal::ExprMonoms<ExprTs...>::for_each(expressions..., [&](const KeyT& key, const auto& coeff) {
+      col.push_back({monoms_.index(key), coeff_to_matrix_element(coeff)});
+    });
+    return col;
   }
 
-  Matrix make_matrix() const {
+  CompressedMatrix make_matrix() const {
     return internal::make_matrix(sparse_cols_, monoms_.size());
   }
 
 private:
-  using SparseElement = internal::SparseElement;
-  using KeyT = CompactVariant<typename ExprTs::ObjectT...>;
-
-  void add_expr_impl(const ExprTs&... expressions) {
-    std::vector<SparseElement> col;
-    add_rows<0>(col, expressions...);
-    sparse_cols_.push_back(std::move(col));
-  }
-
-  template<std::size_t Idx, typename Head, typename... Tail>
-  void add_rows(std::vector<SparseElement>& col, const Head& head, const Tail&... tail) {
-    for (const auto& [term, coeff] : head) {
-      col.push_back({monoms_.index(KeyT{std::in_place_index<Idx>, term}), coeff});
-    }
-    add_rows<Idx + 1>(col, tail...);
-  }
-  template<std::size_t Idx>
-  void add_rows(std::vector<SparseElement>&) {}
+  using KeyT = typename internal::ExprMonoms<ExprTs...>::KeyT;
 
   Enumerator<KeyT> monoms_;
 
@@ -63,37 +112,117 @@ private:
 template<typename ExprT>
 class ExprVectorMatrixBuilder {
 public:
+  using SparseElement = internal::SparseElement;
+
   void add_expr(const std::vector<ExprT>& expressions) {
     auto col = make_col(expressions);
     sparse_cols_.push_back(std::move(col));
   }
 
-  Matrix make_matrix() const {
+  // Converts expressions to a column without adding it to the matrix. Note that this
+  // still registers new monoms (rows).
+  std::vector<SparseElement> make_col(const std::vector<ExprT>& expressions) {
+    std::vector<SparseElement> col;
+    internal::ExprMonoms<std::vector<ExprT>>::for_each(expressions, [&](const KeyT& key, const auto& coeff) {
+      col.push_back({monoms_.index(key), coeff_to_matrix_element(coeff)});
+    });
+    return col;
+  }
+
+  CompressedMatrix make_matrix() const {
     return internal::make_matrix(sparse_cols_, monoms_.size());
   }
 
 private:
+  using KeyT = typename internal::ExprMonoms<std::vector<ExprT>>::KeyT;
+
+  Enumerator<KeyT> monoms_;
+
+  // For each col: for each non-zero value: (row, value)
+  std::vector<std::vector<SparseElement>> sparse_cols_;
+};
+
+
+// Builds the same matrix as `GetExprMatrixBuilder_t<ExprT>`, but converts expressions to columns
+// in parallel. Monoms are enumerated via `ConcurrentEnumerator` and renumbered in the end in order
+// of first occurrence, so the result doesn't depend on thread scheduling.
+template<typename ExprT>
+class ConcurrentExprMatrixBuilder {
+public:
   using SparseElement = internal::SparseElement;
-  using KeyT = std::pair<int, typename ExprT::ObjectT>;
 
-  std::vector<SparseElement> make_col(const std::vector<ExprT>& expressions) {
-    std::vector<SparseElement> col;
-    for (const int expr_idx : range(expressions.size())) {
-      const auto& expr = expressions.at(expr_idx);
-      for (const auto& [term, coeff] : expr) {
-        col.push_back({monoms_.index(KeyT{expr_idx, term}), coeff});
+  // Adds `prepare(x)` for each `x` in `src` as a column.
+  template<typename SrcT, typename PrepareF>
+  void add_exprs(const SrcT& src, const PrepareF& prepare) {
+    auto cols = mapped_parallel(src, [&](const auto& x) {
+      std::vector<SparseElement> col;
+      internal::ExprMonoms<ExprT>::for_each(prepare(x), [&](const auto& key, const auto& coeff) {
+        col.push_back({monoms_.index(key), coeff_to_matrix_element(coeff)});
+      });
+      return col;
+    });
+    append_vector(sparse_cols_, std::move(cols));
+  }
+  void add_exprs(const std::vector<ExprT>& expressions) {
+    add_exprs(expressions, [](const ExprT& expr) -> const ExprT& { return expr; });
+  }
+
+  // Renumbers rows in place, so the builder is consumed.
+  CompressedMatrix make_matrix() && {
+    std::vector<int> row_order(monoms_.size(), -1);
+    int num_rows = 0;
+    auto sparse_cols = std::move(sparse_cols_);
+    for (auto& col : sparse_cols) {
+      for (auto& [row, value] : col) {
+        if (row_order[row] == -1) {
+          row_order[row] = num_rows++;
+        }
+        row = row_order[row];
       }
-    };
-    return col;
+    }
+    return internal::make_matrix(sparse_cols, num_rows);
   }
 
-  Enumerator<KeyT> monoms_;
+private:
+  ConcurrentEnumerator<typename internal::ExprMonoms<ExprT>::KeyT> monoms_;
 
   // For each col: for each non-zero value: (row, value)
   std::vector<std::vector<SparseElement>> sparse_cols_;
 };
 
 
+// Like `GetExprMatrixBuilder_t<ExprT>`, but writes columns to a file as they are added instead of
+// keeping them in memory. Only monoms are kept in memory. Note that, unlike `make_matrix`, this
+// doesn't deduplicate rows.
+template<typename ExprT>
+class SpillingExprMatrixBuilder {
+public:
+  explicit SpillingExprMatrixBuilder(std::string filename)
+    : filename_(std::move(filename)), writer_(filename_) {}
+
+  void add_expr(const ExprT& expr) {
+    std::vector<internal::SparseElement> col;
+    internal::ExprMonoms<ExprT>::for_each(expr, [&](const KeyT& key, const auto& coeff) {
+      col.push_back({monoms_.index(key), coeff_to_matrix_element(coeff)});
+    });
+    writer_.add_col(std::move(col));
+  }
+
+  // Finalizes the file. No expressions can be added afterwards.
+  SpilledMatrix finish() {
+    writer_.finish(monoms_.size());
+    return SpilledMatrix(filename_);
+  }
+
+private:
+  using KeyT = typename internal::ExprMonoms<ExprT>::KeyT;
+
+  std::string filename_;
+  SpilledMatrixWriter writer_;
+  Enumerator<KeyT> monoms_;
+};
+
+
 template<typename... Ts>
 struct GetExprMatrixBuilder { using type = ExprTupleMatrixBuilder<Ts...>; };
 template<typename... Ts>
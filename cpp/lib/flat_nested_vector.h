@@ -0,0 +1,177 @@
+// A sequence of vectors ("parts") stored in one contiguous byte buffer. Designed to be used
+// as a hash map key for coexpressions: compared to a vector of vectors, hashing and equality
+// check operate on a single blob and don't need to visit each part separately.
+//
+// Layout: number of parts, then part sizes (one byte each), then padding to `alignof(T)`,
+// then elements of all parts. An empty vector has no bytes at all.
+//
+// Parts are accessed via read-only views. In order to modify the parts, convert them to
+// a regular vector of vectors with `to_parts` and then back with `from_parts`.
+
+#pragma once
+
+#include <algorithm>
+#include <compare>
+#include <cstring>
+#include <limits>
+
+#include "absl/types/span.h"
+
+#include "check.h"
+#include "memory_usage_micro.h"
+#include "pvector.h"
+#include "string.h"
+#include "util.h"
+
+
+namespace internal {
+constexpr int flat_nested_vector_header_size(int num_parts, int element_alignment) {
+  const int size = 1 + num_parts;
+  return (size + element_alignment - 1) / element_alignment * element_alignment;
+}
+}  // namespace internal
+
+// `N` is the expected buffer size in bytes, see `flat_nested_vector_bytes`.
+template<typename T, int N>
+class FlatNestedVector {
+public:
+  static_assert(std::is_trivially_copyable_v<T> && std::has_unique_object_representations_v<T>);
+
+  using PartView = absl::Span<const T>;
+
+  static constexpr bool kCanInline = PVector<unsigned char, N>::kCanInline;
+
+  FlatNestedVector() = default;
+  template<typename PartT>
+  FlatNestedVector(std::initializer_list<PartT> parts) : FlatNestedVector(from_parts(parts)) {}
+
+  template<typename PartsT>
+  static FlatNestedVector from_parts(const PartsT& parts) {
+    FlatNestedVector ret;
+    const int num_parts = parts.size();
+    if (num_parts == 0) {
+      return ret;
+    }
+    CHECK_LE(num_parts, kMaxNumParts);
+    const int header_size = internal::flat_nested_vector_header_size(num_parts, alignof(T));
+    const int num_elements = sum(parts, [](const auto& part) { return int(part.size()); });
+    ret.bytes_.resize(header_size + num_elements * sizeof(T));
+    unsigned char* header = ret.bytes_.data();
+    T* elements = reinterpret_cast<T*>(header + header_size);
+    header[0] = num_parts;
+    unsigned char* part_size = header + 1;
+    for (const auto& part : parts) {
+      CHECK_LE(part.size(), kMaxPartSize);
+      *part_size++ = part.size();
+      elements = std::copy(part.begin(), part.end(), elements);
+    }
+    return ret;
+  }
+
+  int num_parts() const {
+    return bytes_.empty() ? 0 : bytes_[0];
+  }
+
+  PartView part(int idx) const {
+    ASSERT(0 <= idx && idx < num_parts());
+    const int offset = sum(range(idx), [&](int i) { return int(part_size(i)); });
+    return PartView(elements() + offset, part_size(idx));
+  }
+
+  // Converts to a vector of parts, e.g. `CopartVector<WeightVector<T>>`.
+  template<typename Dst>
+  Dst to_parts() const {
+    using PartT = typename Dst::value_type;
+    Dst ret;
+    ret.reserve(num_parts());
+    const T* part_begin = elements();
+    for (const int i : range(num_parts())) {
+      const T* part_end = part_begin + part_size(i);
+      ret.push_back(PartT(part_begin, part_end));
+      part_begin = part_end;
+    }
+    return ret;
+  }
+
+  bool operator==(const FlatNestedVector& other) const {
+    return bytes_ == other.bytes_;
+  }
+  // Same order as for a vector of vectors: lexicographic by parts.
+  std::weak_ordering operator<=>(const FlatNestedVector& other) const {
+    const int common_parts = std::min(num_parts(), other.num_parts());
+    for (const int i : range(common_parts)) {
+      const PartView a = part(i);
+      const PartView b = other.part(i);
+      const auto cmp = std::lexicographical_compare_three_way(
+        a.begin(), a.end(), b.begin(), b.end(), std::compare_weak_order_fallback
+      );
+      if (cmp != 0) {
+        return cmp;
+      }
+    }
+    return num_parts() <=> other.num_parts();
+  }
+
+  // Equivalent to concatenating vectors of parts, but doesn't unpack the parts.
+  friend FlatNestedVector concat(const FlatNestedVector& a, const FlatNestedVector& b) {
+    if (a.num_parts() == 0) {
+      return b;
+    } else if (b.num_parts() == 0) {
+      return a;
+    }
+    const int num_parts = a.num_parts() + b.num_parts();
+    CHECK_LE(num_parts, kMaxNumParts);
+    const int header_size = internal::flat_nested_vector_header_size(num_parts, alignof(T));
+    const size_t a_element_bytes = a.bytes_.data() + a.bytes_.size() - reinterpret_cast<const unsigned char*>(a.elements());
+    const size_t b_element_bytes = b.bytes_.data() + b.bytes_.size() - reinterpret_cast<const unsigned char*>(b.elements());
+    FlatNestedVector ret;
+    ret.bytes_.resize(header_size + a_element_bytes + b_element_bytes);
+    unsigned char* header = ret.bytes_.data();
+    header[0] = num_parts;
+    std::memcpy(header + 1, a.bytes_.data() + 1, a.num_parts());
+    std::memcpy(header + 1 + a.num_parts(), b.bytes_.data() + 1, b.num_parts());
+    std::memcpy(header + header_size, a.elements(), a_element_bytes);
+    std::memcpy(header + header_size + a_element_bytes, b.elements(), b_element_bytes);
+    return ret;
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const FlatNestedVector& vec) {
+    return H::combine(std::move(h), vec.bytes_);
+  }
+
+  const PVector<unsigned char, N>& bytes() const { return bytes_; }
+
+private:
+  static constexpr int kMaxNumParts = std::numeric_limits<unsigned char>::max();
+  static constexpr size_t kMaxPartSize = std::numeric_limits<unsigned char>::max();
+
+  unsigned char part_size(int idx) const {
+    return bytes_[1 + idx];
+  }
+  const T* elements() const {
+    const int header_size = internal::flat_nested_vector_header_size(num_parts(), alignof(T));
+    return reinterpret_cast<const T*>(bytes_.data() + header_size);
+  }
+
+  PVector<unsigned char, N> bytes_;
+};
+
+// Buffer size for `num_parts` parts with `total_size` elements in total.
+template<typename T>
+constexpr int flat_nested_vector_bytes(int num_parts, int total_size) {
+  return internal::flat_nested_vector_header_size(num_parts, alignof(T)) + total_size * sizeof(T);
+}
+
+template<typename T, int N>
+std::string dump_to_string_impl(const FlatNestedVector<T, N>& v) {
+  return dump_to_string(mapped(range(v.num_parts()), [&](int i) {
+    const auto part = v.part(i);
+    return std::vector<T>(part.begin(), part.end());
+  }));
+}
+
+template<typename T, int N>
+MemoryUsage estimated_heap_usage(const FlatNestedVector<T, N>& v) {
+  return estimated_heap_usage(v.bytes());
+}
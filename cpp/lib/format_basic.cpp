@@ -276,7 +276,7 @@ class AsciiEncoder : public AbstractEncoder {
   std::string num(int v) override {
     return absl::StrCat(v);
   }
-  std::string coeff(int v) override {
+  std::string coeff(int64_t v) override {
     // TODO: Remove left padding here (and in other formatters), this is done
     //   by `to_ostream` for in linear.cpp.
     if (*current_formatting_config().parsable_expression) {
@@ -297,7 +297,7 @@ class AsciiEncoder : public AbstractEncoder {
       else              { return absl::StrCat(v, " "); }
     }
   }
-  std::string coeff_one_liner(int v, bool first_term) override {
+  std::string coeff_one_liner(int64_t v, bool first_term) override {
     if (first_term) {
       if      (v == 1)  { return ""; }
       else if (v == -1) { return "-"; }
@@ -411,7 +411,7 @@ class UnicodeEncoder : public AbstractEncoder {
   std::string num(int v) override {
     return fix_minus(absl::StrCat(v));
   }
-  std::string coeff(int v) override {
+  std::string coeff(int64_t v) override {
     // TODO: Use using "figure space" (U+2007) here.
     if      (v == 0)  { return absl::StrCat(" 0", kThinNbsp); }
     else if (v == 1)  { return absl::StrCat(" +", kThinNbsp); }
@@ -419,7 +419,7 @@ class UnicodeEncoder : public AbstractEncoder {
     else if (v > 0)   { return absl::StrCat("+", v, kThinNbsp); }
     else              { return fix_minus(absl::StrCat(v, kThinNbsp)); }
   }
-  std::string coeff_one_liner(int v, bool first_term) override {
+  std::string coeff_one_liner(int64_t v, bool first_term) override {
     if (first_term) {
       if      (v == 1)  { return ""; }
       else if (v == -1) { return kMinusSign; }
@@ -544,14 +544,14 @@ class LatexEncoder : public AbstractEncoder {
   std::string num(int v) override {
     return absl::StrCat(v);
   }
-  std::string coeff(int v) override {
+  std::string coeff(int64_t v) override {
     if      (v == 0)  { return "0"; }
     else if (v == 1)  { return "+"; }
     else if (v == -1) { return "-"; }
     else if (v > 0)   { return absl::StrCat("+", v); }
     else              { return absl::StrCat(v); }
   }
-  std::string coeff_one_liner(int v, bool first_term) override {
+  std::string coeff_one_liner(int64_t v, bool first_term) override {
     if (first_term) {
       if      (v == 1)  { return ""; }
       else if (v == -1) { return "-"; }
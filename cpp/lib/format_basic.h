@@ -178,8 +178,8 @@ public:
   virtual std::string frac_parens(const std::string& expr) = 0;  // adds parens iff `fraq` is one-liner
 
   virtual std::string num(int v) = 0;
-  virtual std::string coeff(int v) = 0;
-  virtual std::string coeff_one_liner(int v, bool first_term) = 0;
+  virtual std::string coeff(int64_t v) = 0;
+  virtual std::string coeff_one_liner(int64_t v, bool first_term) = 0;
 
   virtual std::string sub(
       const std::string& main,
@@ -270,10 +270,10 @@ inline std::string frac_parens(const std::string& expr) {
 inline std::string num(int v) {
   return current_encoder()->num(v);
 }
-inline std::string coeff(int v) {
+inline std::string coeff(int64_t v) {
   return current_encoder()->coeff(v);
 }
-inline std::string coeff_one_liner(int v, bool first_term) {
+inline std::string coeff_one_liner(int64_t v, bool first_term) {
   return current_encoder()->coeff_one_liner(v, first_term);
 }
 
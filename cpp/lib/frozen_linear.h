@@ -0,0 +1,168 @@
+// An immutable linear expression for read-mostly data such as vector spaces.
+//
+// `Linear` stores terms in a hash map, which has load factor slack and per-slot control bytes,
+// and it carries `LinearAnnotation` inline. `FrozenLinear` stores keys in one sorted array and
+// coefficients in another, and keeps annotations behind a pointer which is null if there are
+// none. Lookups use binary search.
+//
+// `FrozenLinear` supports the read-only part of the `Linear` interface, which is enough to
+// use it as a space element, e.g. in `space_rank` or `ExprVectorMatrixBuilder`. Use `thawed`
+// to get a regular `Linear` back.
+
+#pragma once
+
+#include <memory>
+
+#include "linear.h"
+
+
+template<typename ParamT>
+class FrozenLinear {
+public:
+  using Param = ParamT;
+  using ObjectT = typename ParamT::ObjectT;
+  using StorageT = typename ParamT::StorageT;
+  using CoeffT = linear_coeff_t<ParamT>;
+  using LinearT = Linear<ParamT>;
+
+  class const_iterator {
+  public:
+    const_iterator(const FrozenLinear* expr, int idx) : expr_(expr), idx_(idx) {}
+    std::pair<ObjectT, CoeffT> operator*() const {
+      return {ParamT::key_to_object(expr_->keys_[idx_]), expr_->coeffs_[idx_]};
+    }
+    const_iterator& operator++() { ++idx_; return *this; };
+    bool operator==(const const_iterator& other) const = default;
+  private:
+    const FrozenLinear* expr_ = nullptr;
+    int idx_ = 0;
+  };
+
+  FrozenLinear() {}
+  explicit FrozenLinear(LinearT expr) {
+    if (!expr.annotations().empty()) {
+      annotations_ = std::make_shared<const LinearAnnotation>(expr.annotations());
+    }
+    auto data = std::move(expr).main().release_data();
+    std::vector<std::pair<StorageT, CoeffT>> terms;
+    terms.reserve(data.size());
+    for (auto it = data.begin(); it != data.end(); ) {
+      auto node = data.extract(it++);
+      terms.emplace_back(std::move(node.key()), std::move(node.mapped()));
+    }
+    absl::c_sort(terms, [](const auto& a, const auto& b) { return a.first < b.first; });
+    keys_.reserve(terms.size());
+    coeffs_.reserve(terms.size());
+    for (auto& [key, coeff] : terms) {
+      keys_.push_back(std::move(key));
+      coeffs_.push_back(std::move(coeff));
+    }
+  }
+
+  LinearT thawed() const {
+    typename LinearT::Basic main;
+    foreach_key([&](const StorageT& key, const CoeffT& coeff) {
+      main.add_to_key(key, coeff);
+    });
+    return LinearT(std::move(main), annotations());
+  }
+
+  bool is_zero() const { return keys_.empty(); }
+  bool is_blank() const { return is_zero() && !annotations_; }
+  int num_terms() const { return keys_.size(); }
+  int l0_norm() const { return num_terms(); }
+  int weight() const {
+    CHECK(!is_zero());
+    return ParamT::object_to_weight(element().first);
+  }
+  int dimension() const {
+    CHECK(!is_zero());
+    return ParamT::object_to_dimension(element().first);
+  }
+  auto uniformity_marker() const {
+    CHECK(!is_zero());
+    return ParamT::object_to_uniformity_marker(element().first);
+  }
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, num_terms()); }
+
+  CoeffT operator[](const ObjectT& obj) const {
+    return coeff_for_key(ParamT::object_to_key(obj));
+  }
+  CoeffT coeff_for_key(const StorageT& key) const {
+    const auto it = absl::c_lower_bound(keys_, key);
+    if (it != keys_.end() && *it == key) {
+      return coeffs_[it - keys_.begin()];
+    } else {
+      return 0;
+    }
+  }
+  std::pair<ObjectT, CoeffT> element() const {
+    auto key_coeff = element_key();
+    return {ParamT::key_to_object(key_coeff.first), key_coeff.second};
+  }
+  std::pair<StorageT, CoeffT> element_key() const {
+    CHECK(!is_zero());
+    return {keys_.front(), coeffs_.front()};
+  }
+
+  template<typename F>
+  void foreach(F func) const {
+    foreach_key([&func](const auto& key, const CoeffT& coeff) {
+      func(ParamT::key_to_object(key), coeff);
+    });
+  }
+  template<typename F>
+  void foreach_key(F func) const {
+    for (const int i : range(num_terms())) {
+      func(keys_[i], coeffs_[i]);
+    }
+  }
+
+  const std::vector<StorageT>& keys() const { return keys_; }
+  const std::vector<CoeffT>& coeffs() const { return coeffs_; }
+
+  const LinearAnnotation& annotations() const {
+    static const LinearAnnotation kNoAnnotations;
+    return annotations_ ? *annotations_ : kNoAnnotations;
+  }
+
+  bool operator==(const FrozenLinear& other) const {
+    return keys_ == other.keys_ && coeffs_ == other.coeffs_;
+  }
+
+private:
+  // Sorted by key.
+  std::vector<StorageT> keys_;
+  std::vector<CoeffT> coeffs_;
+  // Annotations are immutable, so they can be shared between copies.
+  std::shared_ptr<const LinearAnnotation> annotations_;
+};
+
+template<typename ParamT>
+FrozenLinear(Linear<ParamT>) -> FrozenLinear<ParamT>;
+
+// Converts each expression of a space to `FrozenLinear`.
+template<typename ParamT>
+std::vector<FrozenLinear<ParamT>> freeze_space(std::vector<Linear<ParamT>> space) {
+  std::vector<FrozenLinear<ParamT>> ret;
+  ret.reserve(space.size());
+  for (auto& expr : space) {
+    ret.push_back(FrozenLinear<ParamT>(std::move(expr)));
+  }
+  return ret;
+}
+
+template<typename ParamT>
+std::ostream& operator<<(std::ostream& os, const FrozenLinear<ParamT>& linear) {
+  return os << linear.thawed();
+}
+
+template<typename ParamT>
+MemoryUsage estimated_heap_usage(const FrozenLinear<ParamT>& expr) {
+  return
+    estimated_heap_usage(expr.keys()) +
+    estimated_heap_usage(expr.coeffs()) +
+    (expr.annotations().empty() ? MemoryUsage{0, 0} : estimated_ram_usage(expr.annotations()));
+}
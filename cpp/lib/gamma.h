@@ -123,14 +123,20 @@ struct GammaICoExprParam {
   using PartExprParam = GammaExprParam;
   using ObjectT = std::vector<std::vector<Gamma>>;
   using PartStorageT = GammaExprParam::StorageT;
-  using StorageT = CopartVector<PartStorageT>;
+  using StorageT = FlatCopartVector<GammaStorage>;
+  using VectorT = CopartVector<PartStorageT>;
   static StorageT object_to_key(const ObjectT& obj) {
-    return mapped_to<StorageT>(obj, GammaExprParam::object_to_key);
+    return vector_to_key(mapped_to<VectorT>(obj, GammaExprParam::object_to_key));
   }
   static ObjectT key_to_object(const StorageT& key) {
-    return mapped(key, GammaExprParam::key_to_object);
+    return mapped(key_to_vector(key), GammaExprParam::key_to_object);
+  }
+  static VectorT key_to_vector(const StorageT& key) {
+    return key.template to_parts<VectorT>();
+  }
+  static StorageT vector_to_key(const VectorT& vec) {
+    return StorageT::from_parts(vec);
   }
-  IDENTITY_VECTOR_FORM
   LYNDON_COMPARE_LENGTH_FIRST
   CO_DERIVE_WEIGHT_AND_UNIFORMITY_MARKER
   static std::string object_to_string(const ObjectT& obj) {
@@ -162,7 +168,7 @@ struct GammaACoExprParam : GammaICoExprParam {
 };
 
 static_assert(GammaExprParam::StorageT::kCanInline);
-// static_assert(GammaNCoExprParam::StorageT::kCanInline);
+static_assert(GammaNCoExprParam::StorageT::kCanInline);
 }  // namespace internal
 
 
@@ -0,0 +1,205 @@
+#include "incremental_rank.h"
+
+#include <givaro/givinteger.h>
+
+#include "absl/container/flat_hash_map.h"
+
+#include "check.h"
+#include "linalg_modular.h"
+#include "util.h"
+
+
+template<typename T>
+using SparseVec = std::vector<std::pair<int, T>>;  // sorted by index
+
+template<typename T>
+struct EchelonRow {
+  SparseVec<T> main;
+  // Coefficients in front of the original columns (only if `track_combinations`).
+  // Index -1 denotes the column being reduced.
+  SparseVec<T> combination;
+};
+
+struct ModularDomain {
+  using T = uint32_t;
+
+  T from_int(int value) const {
+    const int64_t r = static_cast<int64_t>(value) % prime;
+    return r < 0 ? r + prime : r;
+  }
+  T zero() const { return 0; }
+  T one() const { return 1; }
+  bool is_zero(T value) const { return value == 0; }
+  T mul(T a, T b) const { return static_cast<uint64_t>(a) * b % prime; }
+  T sub(T a, T b) const { return a >= b ? a - b : a + prime - b; }
+  void normalize(EchelonRow<T>&) const {}
+
+  uint32_t prime = kRankPrimes[0];
+};
+
+struct IntegerDomain {
+  using T = Givaro::Integer;
+
+  T from_int(int value) const { return T(value); }
+  T zero() const { return T(0); }
+  T one() const { return T(1); }
+  bool is_zero(const T& value) const { return isZero(value); }
+  T mul(const T& a, const T& b) const { return a * b; }
+  T sub(const T& a, const T& b) const { return a - b; }
+
+  // Divides the row by the GCD of its elements to prevent coefficient growth.
+  void normalize(EchelonRow<T>& row) const {
+    T g = zero();
+    for (const auto* vec : {&row.main, &row.combination}) {
+      for (const auto& [idx, value] : *vec) {
+        g = gcd(g, value);
+        if (isOne(g)) {
+          return;
+        }
+      }
+    }
+    if (isZero(g)) {
+      return;
+    }
+    for (auto* vec : {&row.main, &row.combination}) {
+      for (auto& [idx, value] : *vec) {
+        value /= g;
+      }
+    }
+  }
+};
+
+// Returns a*x - b*y.
+template<typename Domain, typename T = typename Domain::T>
+static SparseVec<T> mul_sub(const Domain& domain, const T& a, const SparseVec<T>& x, const T& b, const SparseVec<T>& y) {
+  SparseVec<T> ret;
+  ret.reserve(x.size() + y.size());
+  auto it_x = x.begin();
+  auto it_y = y.begin();
+  while (it_x != x.end() || it_y != y.end()) {
+    if (it_y == y.end() || (it_x != x.end() && it_x->first < it_y->first)) {
+      ret.push_back({it_x->first, domain.mul(a, it_x->second)});
+      ++it_x;
+    } else if (it_x == x.end() || it_y->first < it_x->first) {
+      ret.push_back({it_y->first, domain.sub(domain.zero(), domain.mul(b, it_y->second))});
+      ++it_y;
+    } else {
+      auto value = domain.sub(domain.mul(a, it_x->second), domain.mul(b, it_y->second));
+      if (!domain.is_zero(value)) {
+        ret.push_back({it_x->first, std::move(value)});
+      }
+      ++it_x;
+      ++it_y;
+    }
+  }
+  return ret;
+}
+
+template<typename Domain>
+class IncrementalEliminator : public internal::IncrementalEliminatorInterface {
+public:
+  using T = typename Domain::T;
+
+  IncrementalEliminator(bool track_combinations) : track_combinations_(track_combinations) {}
+
+  int num_cols() const override { return num_cols_; }
+  int rank() const override { return pivots_.size(); }
+
+  bool add_col(const SparseCol& col) override {
+    auto row = reduce(make_row(col, num_cols_));
+    ++num_cols_;
+    if (row.main.empty()) {
+      return false;
+    }
+    const int pivot = row.main.front().first;
+    pivots_.emplace(pivot, std::move(row));
+    return true;
+  }
+
+  bool contains(const SparseCol& col) const override {
+    // Note: combinations are not needed here even if they are tracked.
+    EchelonRow<T> row;
+    row.main = make_vec(col);
+    return reduce(std::move(row)).main.empty();
+  }
+
+  std::optional<std::vector<int>> decompose(const SparseCol& col) const override {
+    CHECK(track_combinations_) << "decompose requires track_combinations";
+    const auto row = reduce(make_row(col, -1));
+    if (!row.main.empty()) {
+      return std::nullopt;
+    }
+    std::vector<int> ret;
+    for (const auto& [idx, value] : row.combination) {
+      if (idx >= 0) {
+        ret.push_back(idx);
+      }
+    }
+    return ret;
+  }
+
+private:
+  SparseVec<T> make_vec(const SparseCol& col) const {
+    SparseVec<T> vec;
+    vec.reserve(col.size());
+    for (const auto& [row, value] : col) {
+      auto v = domain_.from_int(value);
+      if (!domain_.is_zero(v)) {
+        vec.push_back({row, std::move(v)});
+      }
+    }
+    absl::c_sort(vec, [](const auto& a, const auto& b) { return a.first < b.first; });
+    return vec;
+  }
+
+  EchelonRow<T> make_row(const SparseCol& col, int col_index) const {
+    EchelonRow<T> row;
+    row.main = make_vec(col);
+    if (track_combinations_) {
+      row.combination.push_back({col_index, domain_.one()});
+    }
+    return row;
+  }
+
+  // Eliminates the leading element of the row while there is a pivot for it. The resulting row
+  // is zero iff the original row lies in the span of the pivot rows.
+  EchelonRow<T> reduce(EchelonRow<T> row) const {
+    const bool with_combination = !row.combination.empty();
+    while (!row.main.empty()) {
+      const auto it = pivots_.find(row.main.front().first);
+      if (it == pivots_.end()) {
+        break;
+      }
+      const auto& pivot_row = it->second;
+      const T a = pivot_row.main.front().second;
+      const T b = row.main.front().second;
+      row.main = mul_sub(domain_, a, row.main, b, pivot_row.main);
+      if (with_combination) {
+        row.combination = mul_sub(domain_, a, row.combination, b, pivot_row.combination);
+      }
+      domain_.normalize(row);
+    }
+    return row;
+  }
+
+  Domain domain_;
+  bool track_combinations_ = false;
+  int num_cols_ = 0;
+  absl::flat_hash_map<int, EchelonRow<T>> pivots_;  // leading row index -> echelon row
+};
+
+
+IncrementalRankBuilder::IncrementalRankBuilder(RankBackend backend, bool track_combinations) {
+  SWITCH_ENUM_OR_DIE(backend, {
+    case RankBackend::exact:
+      impl_ = std::make_unique<IncrementalEliminator<IntegerDomain>>(track_combinations);
+      return;
+    case RankBackend::modular:
+      impl_ = std::make_unique<IncrementalEliminator<ModularDomain>>(track_combinations);
+      return;
+  });
+}
+
+IncrementalRankBuilder::~IncrementalRankBuilder() {}
+IncrementalRankBuilder::IncrementalRankBuilder(IncrementalRankBuilder&&) = default;
+IncrementalRankBuilder& IncrementalRankBuilder::operator=(IncrementalRankBuilder&&) = default;
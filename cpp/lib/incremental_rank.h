@@ -0,0 +1,69 @@
+// Incremental rank computation: columns are added one by one and the rank is updated after
+// each addition. This is faster than recomputing the rank from scratch when one needs to know
+// the rank for a series of nested spaces (e.g. when checking whether one space contains another).
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "linalg.h"
+
+
+namespace internal {
+class IncrementalEliminatorInterface {
+public:
+  using SparseCol = std::vector<std::pair<int, int>>;  // (row, value)
+
+  virtual ~IncrementalEliminatorInterface() {}
+  virtual int num_cols() const = 0;
+  virtual int rank() const = 0;
+  virtual bool add_col(const SparseCol& col) = 0;
+  virtual bool contains(const SparseCol& col) const = 0;
+  virtual std::optional<std::vector<int>> decompose(const SparseCol& col) const = 0;
+};
+}  // namespace internal
+
+
+// Keeps row echelon form of the matrix consisting of the columns added so far. Columns are
+// given as sparse vectors of (row, value) pairs; rows must be unique, but not necessarily sorted.
+//
+// With `RankBackend::exact` elimination is fraction-free over integers. With `RankBackend::modular`
+// it is done modulo a single large prime; in this case ranks are lower bounds that coincide with
+// the exact ranks with overwhelming probability (note: there is no automatic fallback to exact
+// computations, unlike in `matrix_rank`).
+//
+// If `track_combinations` is true, each echelon row also keeps track of its expression via the
+// original columns. This enables `decompose`, but slows down the computation.
+class IncrementalRankBuilder {
+public:
+  using SparseCol = internal::IncrementalEliminatorInterface::SparseCol;
+
+  explicit IncrementalRankBuilder(
+    RankBackend backend = RankBackend::exact,
+    bool track_combinations = false
+  );
+  ~IncrementalRankBuilder();
+  IncrementalRankBuilder(IncrementalRankBuilder&&);
+  IncrementalRankBuilder& operator=(IncrementalRankBuilder&&);
+
+  // Number of columns added so far, including the ones that didn't increase the rank.
+  int num_cols() const { return impl_->num_cols(); }
+  int rank() const { return impl_->rank(); }
+
+  // Adds a column. Returns true iff the rank increased.
+  bool add_col(const SparseCol& col) { return impl_->add_col(col); }
+
+  // Checks whether the column lies in the span of the columns added so far.
+  bool contains(const SparseCol& col) const { return impl_->contains(col); }
+
+  // If the column lies in the span of the columns added so far, returns indices of the columns
+  // (in order of addition) that are required to express it. Only linearly independent columns
+  // (those for which `add_col` returned true) are used, so the representation is unique.
+  // Requires `track_combinations`.
+  std::optional<std::vector<int>> decompose(const SparseCol& col) const { return impl_->decompose(col); }
+
+private:
+  std::unique_ptr<internal::IncrementalEliminatorInterface> impl_;
+};
@@ -4,19 +4,24 @@
 
 #include "linalg.h"
 
-#include <queue>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <mutex>
 
 #include <linbox/linbox-config.h>
+#include <givaro/givinteger.h>
 #include <givaro/givrational.h>
 #include <linbox/ring/modular.h>
 #include <linbox/matrix/sparse-matrix.h>
 #include <linbox/solutions/rank.h>
 #include <linbox/solutions/solve.h>
 
+#include "absl/strings/str_format.h"
+
 #include "check.h"
-#include "compare.h"
-#include "enumerator.h"
-#include "sorting.h"
+#include "linalg_modular.h"
+#include "parallel_util.h"
 #include "string.h"
 #include "util.h"
 
@@ -33,147 +38,104 @@ namespace LinBox {
 
 
 template<typename Field>
-LinBox::SparseMatrix<Field> to_linbox_matrix(const Matrix& matrix, const Field& field) {
+LinBox::SparseMatrix<Field> to_linbox_matrix(const CompressedMatrix& matrix, const Field& field) {
   LinBox::SparseMatrix<Field> linbox_matrix(field, matrix.rows(), matrix.cols());
-  // Sort triplets first. The order of calls to `setEntry` plays a huge role: `LinBox::rank`
-  // can be five times slower in case of random order compared to sorted.
-  const auto sorted_triplets = sorted(
-    matrix.as_triplets(),
-    cmp::projected([](const auto& t) { return std::pair{t.row, t.col}; })
-  );
-  for (const auto& t : sorted_triplets) {
-    linbox_matrix.setEntry(t.row, t.col, t.value);
+  // Note. The order of calls to `setEntry` plays a huge role: `LinBox::rank` can be five times
+  // slower in case of random order compared to sorted. Row-major traversal is sorted.
+  for (const int row : range(matrix.rows())) {
+    for (const auto& [col, value] : matrix.row(row)) {
+      linbox_matrix.setEntry(row, col, value);
+    }
   }
   return linbox_matrix;
 }
 
-// Finds one diagonal block in a matrix given by `rows` and `cols`, which must be synchronized,
-// i.e. for each element (col, value) in `rows` there must be a corresponding element (row, value)
-// in `cols` and vice versa. Removes the elements corresponding to the block from `rows` and `cols`.
-// Returns the block as a map: (row, col) -> value.
-static absl::flat_hash_map<std::pair<int, int>, int> extract_block(
-  absl::flat_hash_map<int, std::vector<std::pair<int, int>>>& rows,
-  absl::flat_hash_map<int, std::vector<std::pair<int, int>>>& cols
-) {
-  absl::flat_hash_map<std::pair<int, int>, int> block;
-  std::queue<std::pair<int, int>> extraction_queue;  // queue of (row, col)
-  const auto it = rows.begin();
-  const auto it_it = it->second.begin();
-  extraction_queue.push({it->first, it_it->first});
-  while (!extraction_queue.empty()) {
-    const auto [i_row, i_col] = extraction_queue.front();
-    extraction_queue.pop();
-    const auto row = extract_value_or(rows, i_row);
-    const auto col = extract_value_or(cols, i_col);
-    for (const auto& [c, v] : row) {
-      if (block.insert({{i_row, c}, v}).second) {
-        extraction_queue.push({i_row, c});
-      }
+// Splits matrix into blocks if it's block diagonal. Empty rows and columns are dropped.
+// Relative order of rows and columns within each block is preserved.
+static std::vector<CompressedMatrix> get_matrix_diagonal_blocks(const CompressedMatrix& matrix) {
+  std::vector<int> row_block(matrix.rows(), -1);
+  std::vector<int> col_block(matrix.cols(), -1);
+  std::vector<int> block_row_index(matrix.rows(), -1);
+  std::vector<std::vector<int>> block_cols;
+  for (const int start_col : range(matrix.cols())) {
+    if (col_block[start_col] != -1 || matrix.col(start_col).empty()) {
+      continue;
     }
-    for (const auto& [r, v] : col) {
-      if (block.insert({{r, i_col}, v}).second) {
-        extraction_queue.push({r, i_col});
+    const int block = block_cols.size();
+    std::vector<int> rows;
+    std::vector<int> cols = {start_col};
+    col_block[start_col] = block;
+    // Breadth-first search that uses `cols` and `rows` as queues.
+    int next_row = 0;
+    for (int next_col = 0; next_col < cols.size() || next_row < rows.size(); ) {
+      if (next_col < cols.size()) {
+        for (const auto& [row, value] : matrix.col(cols[next_col++])) {
+          if (row_block[row] == -1) {
+            row_block[row] = block;
+            rows.push_back(row);
+          }
+        }
+      } else {
+        for (const auto& [col, value] : matrix.row(rows[next_row++])) {
+          if (col_block[col] == -1) {
+            col_block[col] = block;
+            cols.push_back(col);
+          }
+        }
       }
     }
+    absl::c_sort(rows);
+    for (const int i : range(rows.size())) {
+      block_row_index[rows[i]] = i;
+    }
+    absl::c_sort(cols);
+    block_cols.push_back(std::move(cols));
   }
-  return block;
-}
-
-// Removes empty rows and columns.
-static Matrix compress_matrix(const Matrix& uncompressed) {
-  Enumerator<int> row_indices;
-  Enumerator<int> col_indices;
-  absl::flat_hash_map<std::pair<int, int>, int> compressed_triplets;
-  for (const auto& t : uncompressed.as_triplets()) {
-    compressed_triplets[{row_indices.index(t.row), col_indices.index(t.col)}] = t.value;
-  }
-  return Matrix::from_triplets(compressed_triplets);
-}
-
-#if 0
-static Matrix compress_matrix_keep_rowcol_order(const Matrix& uncompressed) {
-  std::vector<int> row_index_vector;
-  std::vector<int> col_index_vector;
-  for (const auto& t : uncompressed.as_triplets()) {
-    row_index_vector.push_back(t.row);
-    col_index_vector.push_back(t.col);
-  }
-  absl::c_sort(row_index_vector);
-  absl::c_sort(col_index_vector);
-
-  Enumerator<int> row_indices;
-  Enumerator<int> col_indices;
-  for (const auto& idx : row_index_vector) {
-    row_indices.index(idx);
-  }
-  for (const auto& idx : col_index_vector) {
-    col_indices.index(idx);
-  }
-
-  absl::flat_hash_map<std::pair<int, int>, int> compressed_triplets;
-  for (const auto& t : uncompressed.as_triplets()) {
-    compressed_triplets[{row_indices.c_index(t.row), col_indices.c_index(t.col)}] = t.value;
-  }
-  return Matrix(compressed_triplets);
-}
-#endif
 
-// Splits matrix into blocks if it's block diagonal.
-static std::vector<Matrix> get_matrix_diagonal_blocks(const Matrix& matrix) {
-  absl::flat_hash_map<int, std::vector<std::pair<int, int>>> rows;  // row -> (col, value)
-  absl::flat_hash_map<int, std::vector<std::pair<int, int>>> cols;  // col -> (row, value)
-  for (const auto& t : matrix.as_triplets()) {
-    rows[t.row].push_back({t.col, t.value});
-    cols[t.col].push_back({t.row, t.value});
-  }
-  std::vector<Matrix> blocks;
-  while (!rows.empty()) {
-    const auto block = extract_block(rows, cols);
-    int rows = 0, cols = 0;
-    for (const auto& [rowcol, value] : block) {
-      const auto [row, col] = rowcol;
-      rows = std::max(rows, row + 1);
-      cols = std::max(cols, col + 1);
-    }
-    Matrix block_matrix(rows, cols);
-    for (const auto& [rowcol, value] : block) {
-      const auto [row, col] = rowcol;
-      block_matrix(row, col) = value;
+  return mapped(block_cols, [&](const std::vector<int>& cols) {
+    std::vector<std::vector<CompressedMatrix::Element>> sparse_cols;
+    sparse_cols.reserve(cols.size());
+    int num_rows = 0;
+    for (const int col : cols) {
+      auto& sparse_col = sparse_cols.emplace_back();
+      for (const auto& [row, value] : matrix.col(col)) {
+        const int block_row = block_row_index[row];
+        sparse_col.push_back({block_row, value});
+        num_rows = std::max(num_rows, block_row + 1);
+      }
     }
-    blocks.push_back(compress_matrix(block_matrix));
-  }
-  CHECK(cols.empty());
-  return blocks;
+    return CompressedMatrix::from_sparse_cols(num_rows, sparse_cols);
+  });
 }
 
-static Matrix diagonalize_matrix(const Matrix& src) {
-  using CoordValue = std::pair<int, int>;
-  std::optional<Matrix> mat;
-  for (const auto view_type : {MatrixView::RowMajor, MatrixView::ColumnMajor}) {
-    const MatrixView view{mat ? &*mat : &src, view_type};
-    std::vector<std::vector<CoordValue>> lines(view.a_size());
-    for (const auto& t : view.as_triplets()) {
-      lines.at(t.a).push_back({t.b, t.value});
-    }
-    const auto sorted_lines = sorted_by_projection(lines, [](const auto& line) {
-      // Note. Also tried sorting by average coord, but performance was worse.
-      //   Worse than the original even in many cases.
-      const auto [min, max] = minmax_value(line);
-      return (max.first - min.first);
+// Permutes rows and then columns so that the non-zero elements are close to the diagonal.
+static CompressedMatrix diagonalize_matrix(const CompressedMatrix& src) {
+  CompressedMatrix mat = src;
+  // Each pass sorts rows and transposes the matrix: first rows, then columns.
+  for (EACH : range(2)) {
+    std::vector<int> order = to_vector(range(mat.rows()));
+    // Note. Also tried sorting by average coord, but performance was worse.
+    //   Worse than the original even in many cases.
+    const auto span = [&](int row) {
+      const auto line = mat.row(row);
+      return line.empty() ? 0 : line.back().first - line.front().first;
+    };
+    absl::c_sort(order, [&](int a, int b) {
+      return std::pair{span(a), a} < std::pair{span(b), b};
     });
-    Matrix new_mat(src.rows(), src.cols());
-    for (const int a : range(sorted_lines.size())) {
-      for (const auto& [b, value] : sorted_lines[a]) {
-        new_mat(view_type == MatrixView::RowMajor ? std::pair{a, b} : std::pair{b, a}) = value;
-      }
+    std::vector<std::vector<CompressedMatrix::Element>> rows;
+    rows.reserve(order.size());
+    for (const int row : order) {
+      const auto line = mat.row(row);
+      rows.push_back(std::vector(line.begin(), line.end()));
     }
-    mat = std::move(new_mat);
+    // Rows of `mat` become columns of the new matrix, i.e. it is transposed.
+    mat = CompressedMatrix::from_sparse_cols(mat.cols(), rows);
   }
-  CHECK(mat.has_value());
-  return *mat;
+  return mat;
 }
 
-std::vector<double> linear_solve(const Matrix& matrix, const std::vector<int>& rhs) {
+std::vector<double> linear_solve(const CompressedMatrix& matrix, const std::vector<int>& rhs) {
   CHECK_EQ(matrix.rows(), rhs.size());
 
   using Field = Givaro::QField<Givaro::Rational>;
@@ -191,29 +153,35 @@ std::vector<double> linear_solve(const Matrix& matrix, const std::vector<int>& r
   return mapped(linbox_result, [](const auto& v) { return static_cast<double>(v); });
 }
 
-std::vector<int> find_kernel_vector(const Matrix& matrix) {
+std::vector<int> find_kernel_vector(const CompressedMatrix& matrix) {
   using Field = Givaro::QField<Givaro::Rational>;
   Field field;
 
-  int min_nonzero_col = std::numeric_limits<int>::max();
-  for (const auto& t : matrix.as_triplets()) {
-    if (t.value != 0) {
-      min_nonzero_col = std::min(min_nonzero_col, t.col);
+  int min_nonzero_col = 0;
+  while (min_nonzero_col < matrix.cols() && matrix.col(min_nonzero_col).empty()) {
+    ++min_nonzero_col;
+  }
+  if (min_nonzero_col == matrix.cols()) {
+    std::vector<int> ret(matrix.cols(), 0);
+    if (!ret.empty()) {
+      ret.front() = 1;
     }
+    return ret;
   }
 
   LinBox::DenseVector<Field> linbox_rhs(field, matrix.rows());
-  Matrix matrix_fixcol(matrix.rows(), matrix.cols());
-  for (const auto& t : matrix.as_triplets()) {
-    if (t.col == min_nonzero_col) {
-      linbox_rhs[t.row] = -t.value;
-    } else {
-      matrix_fixcol(t.row, t.col) = t.value;
+  for (const auto& [row, value] : matrix.col(min_nonzero_col)) {
+    linbox_rhs[row] = -value;
+  }
+  LinBox::SparseMatrix<Field> linbox_matrix(field, matrix.rows(), matrix.cols());
+  for (const int row : range(matrix.rows())) {
+    for (const auto& [col, value] : matrix.row(row)) {
+      if (col != min_nonzero_col) {
+        linbox_matrix.setEntry(row, col, value);
+      }
     }
   }
-
-  auto linbox_matrix = to_linbox_matrix(matrix_fixcol, field);
-  LinBox::DenseVector<Field> linbox_result(field, matrix_fixcol.cols());
+  LinBox::DenseVector<Field> linbox_result(field, matrix.cols());
 
   try {
     LinBox::solveInPlace(linbox_result, linbox_matrix, linbox_rhs);
@@ -223,24 +191,26 @@ std::vector<int> find_kernel_vector(const Matrix& matrix) {
   // TODO: Deal with this element must be zero.
   linbox_result[min_nonzero_col] = 1;
 
-  const int denom_lcm = absl::c_accumulate(
-    linbox_result,
-    1,
-    [](int lcm, const auto& v) { return lcm * v.deno(); }
-  );
+  // Compute in arbitrary precision: the product of denominators overflows `int` easily.
+  Givaro::Integer denom_lcm = 1;
+  for (const auto& v : linbox_result) {
+    denom_lcm = lcm(denom_lcm, Givaro::Integer(v.deno()));
+  }
   return mapped(linbox_result, [&](const auto& v) {
-    return static_cast<int>(v.nume()) * denom_lcm / static_cast<int>(v.deno());
+    const Givaro::Integer value = Givaro::Integer(v.nume()) * (denom_lcm / Givaro::Integer(v.deno()));
+    CHECK(value <= std::numeric_limits<int>::max() && value >= std::numeric_limits<int>::min())
+        << "Kernel vector coefficient doesn't fit into int";
+    return static_cast<int>(value);
   });
 }
 
-int matrix_rank_raw_linbox(const Matrix& matrix) {
-  const auto& triplets = matrix.as_triplets();
-  if (triplets.empty()) {
+int matrix_rank_raw_linbox(const CompressedMatrix& matrix) {
+  if (matrix.num_nonzero() == 0) {
     // Extend rank definition to empty matrices.
     return 0;
-  } else if (triplets.size() == 1) {
+  } else if (matrix.num_nonzero() == 1) {
     // Speed up block rank computation.
-    return triplets.front().value == 0 ? 0 : 1;
+    return 1;
   }
   // Optimization potential: Faster implementation for other small matrices (to speed up block rank).
 
@@ -263,6 +233,7 @@ int matrix_rank_raw_linbox(const Matrix& matrix) {
   // and zero as non-zero.
   //   using Field = Givaro::Modular<int>;
   //   Field field(1000003u);
+  // Note. `RankBackend::modular` provides modular rank without going through LinBox.
 
   auto linbox_matrix = to_linbox_matrix(matrix, field);
 
@@ -273,30 +244,124 @@ int matrix_rank_raw_linbox(const Matrix& matrix) {
   return rank;
 }
 
+// LinBox is not guaranteed to be thread-safe (e.g. the global commentator keeps a stack of
+// activities), so all calls into LinBox rank are serialized. Preconditioning and native
+// modular elimination run in parallel.
+static std::mutex linbox_rank_mutex;
+
+static int block_rank_linbox(const CompressedMatrix& block, double* lock_wait_seconds) {
+  const auto preconditioned = diagonalize_matrix(sort_unique_rows(sort_unique_cols(block)));
+  const auto wait_start = std::chrono::steady_clock::now();
+  std::lock_guard lock(linbox_rank_mutex);
+  *lock_wait_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - wait_start).count();
+  return matrix_rank_raw_linbox(preconditioned);
+}
+
+// Rank modulo a prime is a lower bound for the rank over integers. So if the block has full
+// rank modulo a prime, this is the exact rank, and LinBox is not needed. This is checked with
+// native elimination, which is thread-safe, so only rank-deficient blocks are serialized.
+static int block_rank_exact(const CompressedMatrix& block, double* lock_wait_seconds) {
+  const int rank_mod_p = matrix_rank_mod_prime(block, kRankPrimes[0]);
+  if (rank_mod_p == std::min(block.rows(), block.cols())) {
+    return rank_mod_p;
+  }
+  return block_rank_linbox(block, lock_wait_seconds);
+}
+
+// Computes rank modulo two different primes. Returns the result if they match, otherwise
+// falls back to exact computation.
+static int block_rank_modular(const CompressedMatrix& block, double* lock_wait_seconds) {
+  const int rank_a = matrix_rank_mod_prime(block, kRankPrimes[0]);
+  const int rank_b = matrix_rank_mod_prime(block, kRankPrimes[1]);
+  if (rank_a == rank_b) {
+    return rank_a;
+  }
+  return block_rank_linbox(block, lock_wait_seconds);
+}
+
+static int block_rank(const CompressedMatrix& block, RankBackend backend, double* lock_wait_seconds) {
+  SWITCH_ENUM_OR_DIE(backend, {
+    case RankBackend::exact: return block_rank_exact(block, lock_wait_seconds);
+    case RankBackend::modular: return block_rank_modular(block, lock_wait_seconds);
+  });
+}
+
+static std::atomic<int> matrix_rank_num_threads = 0;
+
+void set_matrix_rank_num_threads(int num_threads) {
+  matrix_rank_num_threads = num_threads;
+}
+
 // Computes matrix rank after preconditioning. This is not guaranteed to be faster than
 // `matrix_rank_raw_linbox`. In particular, it could to be slower when there is only block.
 // However it tends to be faster on average, especially for large matrices.
-static int matrix_rank_preconditioned(const Matrix& matrix) {
-  return sum(
-    get_matrix_diagonal_blocks(matrix),
-    [](const auto& b) {
-      return matrix_rank_raw_linbox(diagonalize_matrix(sort_unique_rows(sort_unique_cols(b))));
-    }
-  );
+//
+// Blocks are processed in parallel, largest first. Block sizes typically vary a lot, so static
+// partitioning would be badly imbalanced; hence the work stealing.
+static int matrix_rank_preconditioned(const CompressedMatrix& matrix, RankBackend backend, MatrixRankStats* stats) {
+  auto blocks = get_matrix_diagonal_blocks(matrix);
+  absl::c_stable_sort(blocks, [](const CompressedMatrix& a, const CompressedMatrix& b) {
+    return a.num_nonzero() > b.num_nonzero();
+  });
+  std::vector<MatrixRankStats::Block> block_stats(blocks.size());
+  // Same as in `parallel_for_work_stealing`: there is no point in having more threads than blocks.
+  const int num_threads = PARALLELISM_IMPLEMENTATION == 0
+    ? 1
+    : std::min<int>(resolve_num_threads(matrix_rank_num_threads), blocks.size());
+  parallel_for_work_stealing(blocks.size(), num_threads, [&](int idx) {
+    const auto& block = blocks[idx];
+    double lock_wait_seconds = 0;
+    const auto start = std::chrono::steady_clock::now();
+    const int rank = block_rank(block, backend, &lock_wait_seconds);
+    const auto finish = std::chrono::steady_clock::now();
+    block_stats[idx] = MatrixRankStats::Block{
+      block.rows(),
+      block.cols(),
+      block.num_nonzero(),
+      rank,
+      std::chrono::duration<double>(finish - start).count() - lock_wait_seconds,
+      lock_wait_seconds,
+    };
+  });
+  if (stats) {
+    stats->num_threads = num_threads;
+    stats->blocks = block_stats;
+  }
+  return sum(block_stats, [](const auto& b) { return b.rank; });
 }
 
-#if 1
-int matrix_rank(const Matrix& matrix) {
-  return matrix_rank_preconditioned(matrix);
+int matrix_rank(const CompressedMatrix& matrix, RankBackend backend, MatrixRankStats* stats) {
+  return matrix_rank_preconditioned(matrix, backend, stats);
 }
-#else
-int matrix_rank(const Matrix& matrix) {
+
+std::string to_string(const MatrixRankStats& stats) {
+  const double total_seconds = sum(stats.blocks, [](const auto& b) { return b.seconds; });
+  const double total_lock_wait_seconds = sum(stats.blocks, [](const auto& b) { return b.lock_wait_seconds; });
+  std::string ret = absl::StrFormat(
+    "%d blocks, %d threads, %.2fs total block time, %.2fs waiting for LinBox",
+    stats.blocks.size(), stats.num_threads, total_seconds, total_lock_wait_seconds
+  );
+  for (const auto& b : stats.blocks) {
+    absl::StrAppendFormat(
+      &ret, "\n  %dx%d, %d elements: rank %d, %.3fs (+%.3fs waiting)",
+      b.rows, b.cols, b.num_nonzero, b.rank, b.seconds, b.lock_wait_seconds
+    );
+  }
+  return ret;
+}
+
+#if 0
+// Debug version: verifies that all backends agree.
+int matrix_rank_all_backends(const CompressedMatrix& matrix) {
   Profiler profiler;
   const int rank_orig = matrix_rank_raw_linbox(matrix);
   profiler.finish("rank (raw)");
-  const int rank_preconditioned = matrix_rank_preconditioned(matrix);
-  profiler.finish("rank (preconditioned)");
-  CHECK_EQ(rank_orig, rank_preconditioned);
+  const int rank_exact = matrix_rank(matrix, RankBackend::exact);
+  profiler.finish("rank (exact)");
+  const int rank_modular = matrix_rank(matrix, RankBackend::modular);
+  profiler.finish("rank (modular)");
+  CHECK_EQ(rank_orig, rank_exact);
+  CHECK_EQ(rank_orig, rank_modular);
   return rank_orig;
 }
 #endif
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <string>
 #include <vector>
 
 #include "matrix.h"
@@ -9,12 +10,50 @@
 // If there is no solution, returns zero vector or aborts.
 // TODO: Consistent error handling.
 // TODO: Return a rational instead.
-std::vector<double> linear_solve(const Matrix& matrix, const std::vector<int>& rhs);
+std::vector<double> linear_solve(const CompressedMatrix& matrix, const std::vector<int>& rhs);
 
 // Returns some vector from matrix nullspace.
+// If the matrix is zero, returns the first basis vector.
 // If there is no solution, returns zero vector or aborts.
 // TODO: Consistent error handling.
-std::vector<int> find_kernel_vector(const Matrix& matrix);
+std::vector<int> find_kernel_vector(const CompressedMatrix& matrix);
 
-// Returns matrix rank.
-int matrix_rank(const Matrix& matrix);
+enum class RankBackend {
+  // Exact rank over integers. Blocks that have full rank modulo a prime are known to have full
+  // rank over integers, so only the remaining blocks go to LinBox.
+  exact,
+  // Rank modulo two large primes via native sparse elimination (see `linalg_modular.h`).
+  // Falls back to `exact` if the results differ. In theory, could return a lower rank if
+  // both primes happen to divide the same minors; in practice this doesn't happen.
+  modular,
+};
+
+// Statistics collected by `matrix_rank`. The matrix is split into diagonal blocks, and the rank
+// of each block is computed separately.
+struct MatrixRankStats {
+  struct Block {
+    int rows = 0;
+    int cols = 0;
+    int num_nonzero = 0;
+    int rank = 0;
+    double seconds = 0;  // excluding `lock_wait_seconds`
+    // Time spent waiting for other threads to finish with LinBox, which is not thread-safe.
+    double lock_wait_seconds = 0;
+  };
+
+  int num_threads = 0;  // max concurrency, see `parallel_for_work_stealing`
+  std::vector<Block> blocks;  // from largest to smallest
+};
+
+std::string to_string(const MatrixRankStats& stats);
+
+// Sets the number of threads used by `matrix_rank` to process diagonal blocks.
+// Non-positive value means hardware concurrency (this is the default).
+void set_matrix_rank_num_threads(int num_threads);
+
+// Returns matrix rank. If `stats` is not null, fills it with computation statistics.
+int matrix_rank(
+  const CompressedMatrix& matrix,
+  RankBackend backend = RankBackend::exact,
+  MatrixRankStats* stats = nullptr
+);
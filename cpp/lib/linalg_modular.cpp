@@ -0,0 +1,160 @@
+#include "linalg_modular.h"
+
+#include <queue>
+
+#include "check.h"
+#include "range.h"
+
+
+struct ModEntry {
+  int col = 0;
+  uint32_t value = 0;
+};
+
+using ModRow = std::vector<ModEntry>;
+
+static uint32_t mul_mod(uint32_t a, uint32_t b, uint32_t prime) {
+  return static_cast<uint64_t>(a) * b % prime;
+}
+
+static uint32_t sub_mod(uint32_t a, uint32_t b, uint32_t prime) {
+  return a >= b ? a - b : a + prime - b;
+}
+
+static uint32_t pow_mod(uint32_t x, uint32_t p, uint32_t prime) {
+  uint32_t ret = 1;
+  while (p > 0) {
+    if (p % 2 == 1) {
+      ret = mul_mod(ret, x, prime);
+    }
+    x = mul_mod(x, x, prime);
+    p /= 2;
+  }
+  return ret;
+}
+
+static uint32_t inverse_mod(uint32_t x, uint32_t prime) {
+  CHECK_NE(x, 0);
+  return pow_mod(x, prime - 2, prime);
+}
+
+static uint32_t to_residue(int value, uint32_t prime) {
+  const int64_t r = static_cast<int64_t>(value) % prime;
+  return r < 0 ? r + prime : r;
+}
+
+static const ModEntry* find_col(const ModRow& row, int col) {
+  const auto it = std::lower_bound(row.begin(), row.end(), col, [](const ModEntry& e, int c) {
+    return e.col < c;
+  });
+  return (it != row.end() && it->col == col) ? &*it : nullptr;
+}
+
+class ModularEliminator {
+public:
+  ModularEliminator(const CompressedMatrix& matrix, uint32_t prime)
+    : prime_(prime), rows_(matrix.rows()), col_rows_(matrix.cols()), col_count_(matrix.cols()) {
+    for (const int r : range(rows_.size())) {
+      auto& row = rows_[r];
+      for (const auto& [col, matrix_value] : matrix.row(r)) {
+        const uint32_t value = to_residue(matrix_value, prime_);
+        if (value != 0) {
+          row.push_back({col, value});
+          col_rows_[col].push_back(r);
+          ++col_count_[col];
+        }
+      }
+    }
+  }
+
+  int rank() {
+    // Min-heap of (row size, row index). Entries become stale when a row changes; these are
+    // detected by comparing the size and skipped.
+    using QueueEntry = std::pair<int, int>;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+    for (const int r : range(rows_.size())) {
+      if (!rows_[r].empty()) {
+        queue.push({rows_[r].size(), r});
+      }
+    }
+    std::vector<bool> eliminated(rows_.size(), false);
+    int rank = 0;
+    while (!queue.empty()) {
+      const auto [size, r] = queue.top();
+      queue.pop();
+      if (eliminated[r] || rows_[r].size() != size || size == 0) {
+        continue;
+      }
+      eliminated[r] = true;
+      ++rank;
+      const ModRow pivot_row = std::move(rows_[r]);
+      rows_[r].clear();
+      const ModEntry& pivot = *absl::c_min_element(pivot_row, [&](const ModEntry& a, const ModEntry& b) {
+        return col_count_[a.col] < col_count_[b.col];
+      });
+      const uint32_t pivot_inv = inverse_mod(pivot.value, prime_);
+      const auto pivot_col_rows = std::move(col_rows_[pivot.col]);
+      col_rows_[pivot.col].clear();
+      for (const int other : pivot_col_rows) {
+        if (eliminated[other]) {
+          continue;
+        }
+        const ModEntry* e = find_col(rows_[other], pivot.col);
+        if (e == nullptr) {
+          continue;  // stale reference
+        }
+        const uint32_t factor = mul_mod(e->value, pivot_inv, prime_);
+        subtract_row(other, pivot_row, factor);
+        if (!rows_[other].empty()) {
+          queue.push({rows_[other].size(), other});
+        }
+      }
+      for (const auto& e : pivot_row) {
+        --col_count_[e.col];
+      }
+    }
+    return rank;
+  }
+
+private:
+  // rows_[dst] -= factor * src
+  void subtract_row(int dst, const ModRow& src, uint32_t factor) {
+    const ModRow& old = rows_[dst];
+    ModRow result;
+    result.reserve(old.size() + src.size());
+    auto a = old.begin();
+    auto b = src.begin();
+    while (a != old.end() || b != src.end()) {
+      if (b == src.end() || (a != old.end() && a->col < b->col)) {
+        result.push_back(*a);
+        ++a;
+      } else if (a == old.end() || b->col < a->col) {
+        result.push_back({b->col, sub_mod(0, mul_mod(factor, b->value, prime_), prime_)});
+        col_rows_[b->col].push_back(dst);
+        ++col_count_[b->col];
+        ++b;
+      } else {
+        const uint32_t value = sub_mod(a->value, mul_mod(factor, b->value, prime_), prime_);
+        if (value != 0) {
+          result.push_back({a->col, value});
+        } else {
+          --col_count_[a->col];
+        }
+        ++a;
+        ++b;
+      }
+    }
+    rows_[dst] = std::move(result);
+  }
+
+  uint32_t prime_ = 0;
+  std::vector<ModRow> rows_;
+  std::vector<std::vector<int>> col_rows_;  // may contain stale references
+  std::vector<int> col_count_;  // exact number of non-zero elements in non-eliminated rows
+};
+
+
+int matrix_rank_mod_prime(const CompressedMatrix& matrix, uint32_t prime) {
+  CHECK_LT(prime, 1u << 31);
+  return ModularEliminator(matrix, prime).rank();
+}
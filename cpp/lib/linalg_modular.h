@@ -0,0 +1,28 @@
+// Native sparse linear algebra over prime fields Z/pZ for word-size primes.
+//
+// This is used as a fast alternative to LinBox for rank computations. Rank modulo p never
+// exceeds the rank over Q, and for a random large prime it is equal to it with overwhelming
+// probability. Thus computing rank modulo several primes and comparing the results gives
+// a reliable answer, which can be verified by exact computation in case of mismatch.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "coeff.h"
+#include "matrix.h"
+
+
+// Primes just below 2^31. Products of two residues fit into `uint64_t`. `RankBackend::modular`
+// compares ranks modulo both of them.
+constexpr std::array<uint32_t, 2> kRankPrimes = {2147483647u, 2147483629u};
+static_assert(ModPCoeff::kModulus == kRankPrimes[0], "See `ModPCoeff` in coeff.h");
+
+// Returns matrix rank modulo `prime`. The prime must be less than 2^31.
+//
+// Uses sparse Gaussian elimination with Markowitz-style pivoting: the next pivot row is the
+// shortest remaining row, and the pivot column within that row is the one with the fewest
+// non-zero elements. This keeps the fill-in low on matrices that are close to block diagonal,
+// which is typically the case for matrices produced by `ExprMatrixBuilder`.
+int matrix_rank_mod_prime(const CompressedMatrix& matrix, uint32_t prime);
@@ -5,25 +5,45 @@
 #include "space_algebra.h"
 
 
-// Optimization potential: If some expressions in `needle` contain unique terms, use these
-//   to determine whether the expressions need to be included, without rank computations.
-// Optimization potential: Fewer rank computations
-// Optimization potential: Re-use matrix builder
+// Returns a minimal (by inclusion) subset of `haystack` such that its span contains `needle`.
+//
+// The result is computed in one pass: first, a basis of `haystack` is selected greedily; then
+// every `needle` element is expressed via the basis (this representation is unique) and all
+// basis elements with non-zero coefficients are kept.
+//
+// Elimination is done modulo a prime, which doesn't suffer from coefficient growth. Columns that
+// are independent modulo a prime are independent over integers, and a coefficient that is
+// non-zero modulo a prime is non-zero over integers. So the result is correct as long as it
+// really contains `needle`, which is verified with a single exact rank computation. In the
+// unlikely case it doesn't, the computation is repeated over integers.
 template<typename SpaceT>
 SpaceT minimal_containing_subspace(const SpaceT& haystack, const SpaceT& needle) {
-  CHECK(space_contains(haystack, needle, std::identity{}));
-  auto ret = haystack;
-  int idx = 0;
-  while (idx < ret.size()) {
-    auto new_ret = ret;
-    new_ret.erase(new_ret.begin() + idx);
-    if (space_contains(new_ret, needle, std::identity{})) {
-      ret = std::move(new_ret);
-    } else {
-      ++idx;
+  using ExprT = typename SpaceT::value_type;
+  check_spaces(haystack, needle);
+  const auto select = [&](RankBackend backend) -> std::optional<SpaceT> {
+    SpaceRankBuilder<ExprT> rank_builder(backend, /* track_combinations = */ true);
+    for (const auto& expr : haystack) {
+      rank_builder.add_expr(expr);
     }
+    std::vector<bool> keep(haystack.size(), false);
+    for (const auto& expr : needle) {
+      const auto indices = rank_builder.decompose(expr);
+      if (!indices.has_value()) {
+        return std::nullopt;
+      }
+      for (const int idx : *indices) {
+        keep.at(idx) = true;
+      }
+    }
+    return choose_by_mask(haystack, keep);
+  };
+  auto ret = select(RankBackend::modular);
+  // The result is linearly independent, so its rank is its size.
+  if (!ret.has_value() || space_rank(concat(*ret, needle), std::identity{}) != ret->size()) {
+    ret = select(RankBackend::exact);
+    CHECK(ret.has_value()) << "haystack does not contain needle";
   }
-  return ret;
+  return *ret;
 }
 
 // TODO: Add a version based on `linear_solve`. Note that even after this is done, this
@@ -90,18 +110,27 @@ ExprT find_equation(ExprT expr, const std::vector<ExprT>& space, const std::vect
   return expr;
 }
 
-// Optimization potential: Re-use matrix builder
+// Selects a basis greedily. Like in `minimal_containing_subspace`, elimination is done modulo a
+// prime: the selected expressions are always linearly independent, and they form a basis iff
+// their number is equal to the exact rank of the space. This is verified with a single exact
+// rank computation; in the unlikely case of a mismatch the basis is selected over integers.
 template<typename SpaceT, typename PrepareF>
 SpaceT space_basis(const SpaceT& space, const PrepareF& prepare) {
-  SpaceT ret;
-  int rank = 0;
-  for (const auto& expr : mapped(space, prepare)) {
-    ret.push_back(expr);
-    const int new_rank = space_rank(ret, std::identity{});
-    if (new_rank == rank) {
-      ret.pop_back();
+  using ExprT = typename SpaceT::value_type;
+  const auto prepared = mapped(space, prepare);
+  const auto select = [&](RankBackend backend) {
+    SpaceRankBuilder<ExprT> rank_builder(backend);
+    SpaceT ret;
+    for (const auto& expr : prepared) {
+      if (rank_builder.add_expr(expr)) {
+        ret.push_back(expr);
+      }
     }
-    rank = new_rank;
+    return ret;
+  };
+  SpaceT ret = select(RankBackend::modular);
+  if (space_rank(prepared, std::identity{}) != ret.size()) {
+    ret = select(RankBackend::exact);
   }
   return ret;
 }
@@ -3,7 +3,8 @@
 // Linear expressions are strongly typed and polymorphic. I.e. each expression stores
 // objects of one particular type, but there can be many types of linear expressions.
 // A linear expression is essentially a map from type T (object) to integer (coefficient)
-// with a set of operation defined on it.
+// with a set of operation defined on it. The coefficient type is `int` by default and
+// can be changed via the `CoeffT` param (see coeff.h).
 //
 //
 // # Linear expression params
@@ -34,6 +35,7 @@
 //   * `operator[](x)` returns a if the expression has term a*x or 0 otherwise.
 //   * `add_to(x, v)` adds v to the coefficient at x.
 //      Equivalent to `expr += v * ExprType::single(x)`, but faster.
+//     When adding many terms at once, consider `LinearAccumulator`.
 //   * `element()` returns some {term, coeff} pair assuming the expression is not zero.
 //   * `pop()` removes the term returned by `element`.
 //
@@ -91,6 +93,8 @@
 
 #include "absl/container/flat_hash_map.h"
 
+#include "arena.h"
+#include "coeff.h"
 #include "compare.h"
 #include "format.h"
 #include "memory_usage_micro.h"
@@ -110,6 +114,7 @@ struct SimpleLinearParam {
   using ObjectT = T;
   IDENTITY_STORAGE_FORM
   // can be overwritten if necessary
+  using CoeffT = int;  // see coeff.h
   static std::string object_to_string(const ObjectT& obj) { return to_string(obj); }
 
   // === left to define (optional; if missing the corresponding functionality will be unavailable):
@@ -223,27 +228,55 @@ template <typename T>
 inline constexpr bool is_any_linear_v = is_linear_v<T> || is_basic_linear_v<T>;
 
 
+// Params that don't derive from `SimpleLinearParam` use `int` coefficients unless they define
+// `CoeffT` themselves.
+template<typename ParamT, typename = void>
+struct linear_coeff { using type = int; };
 template<typename ParamT>
-class Linear;
+struct linear_coeff<ParamT, std::void_t<typename ParamT::CoeffT>> { using type = typename ParamT::CoeffT; };
+template<typename ParamT>
+using linear_coeff_t = typename linear_coeff<ParamT>::type;
+
 
 template<typename ParamT>
+class Linear;
+template<
+  typename ParamT,
+  typename AllocatorT = std::allocator<std::pair<const typename ParamT::StorageT, linear_coeff_t<ParamT>>>
+>
+class LinearAccumulator;
+
+// `AllocatorT` can be changed in order to store short-lived expressions in an arena,
+// see `ArenaBasicLinear`.
+template<
+  typename ParamT,
+  typename AllocatorT = std::allocator<std::pair<const typename ParamT::StorageT, linear_coeff_t<ParamT>>>
+>
 class BasicLinear {
 public:
   using Param = ParamT;
   using ObjectT = typename ParamT::ObjectT;
   using StorageT = typename ParamT::StorageT;
+  using CoeffT = linear_coeff_t<ParamT>;
   using Full = Linear<ParamT>;
+  using Accumulator = LinearAccumulator<ParamT, AllocatorT>;
 #if DISABLE_PACKING
-  using ContainerT = std::unordered_map<StorageT, int, absl::Hash<StorageT>>;
+  using ContainerT = std::unordered_map<StorageT, CoeffT, absl::Hash<StorageT>, std::equal_to<StorageT>, AllocatorT>;
 #else
-  using ContainerT = absl::flat_hash_map<StorageT, int>;
+  using ContainerT = absl::flat_hash_map<
+    StorageT,
+    CoeffT,
+    typename absl::flat_hash_map<StorageT, CoeffT>::hasher,
+    typename absl::flat_hash_map<StorageT, CoeffT>::key_equal,
+    AllocatorT
+  >;
 #endif
   using const_key_iterator = typename ContainerT::const_iterator;
 
   class const_iterator {
   public:
     explicit const_iterator(const_key_iterator it) : it_(std::move(it)) {}
-    std::pair<ObjectT, int> operator*() const { return {ParamT::key_to_object(it_->first), it_->second}; }
+    std::pair<ObjectT, CoeffT> operator*() const { return {ParamT::key_to_object(it_->first), it_->second}; }
     const_iterator& operator++() { ++it_; return *this; };
     bool operator==(const const_iterator& other) const = default;
   private:
@@ -292,9 +325,9 @@ public:
   bool is_zero() const { return data_.empty(); }
   int num_terms() const { return data_.size(); }
   int l0_norm() const { return num_terms(); }
-  int l1_norm() const {
-    int ret = 0;
-    foreach_key([&](const auto&, int coeff) { ret += std::abs(coeff); });
+  auto l1_norm() const {
+    decltype(coeff_abs(CoeffT{})) ret = 0;
+    foreach_key([&](const auto&, const CoeffT& coeff) { ret = coeff_add(ret, coeff_abs(coeff)); });
     return ret;
   }
   int weight() const {
@@ -317,10 +350,10 @@ public:
   const_iterator begin() const { return const_iterator(begin_key()); }
   const_iterator end() const { return const_iterator(end_key()); }
 
-  int operator[](const ObjectT& obj) const {
+  CoeffT operator[](const ObjectT& obj) const {
     return coeff_for_key(ParamT::object_to_key(obj));
   }
-  int coeff_for_key(const StorageT& key) const {
+  CoeffT coeff_for_key(const StorageT& key) const {
     const auto it = data_.find(key);
     if (it != data_.end()) {
       return it->second;
@@ -329,29 +362,31 @@ public:
     }
   }
   const ContainerT& data() const { return data_; }
+  // Gives away the underlying container, e.g. to move the keys out.
+  ContainerT release_data() && { return std::move(data_); }
 
-  void add_to(const ObjectT& obj, int x) {
+  void add_to(const ObjectT& obj, const CoeffT& x) {
     add_to_key(ParamT::object_to_key(obj), x);
   }
-  void add_to_key(const StorageT& key, int x) {
-    int& value = data_[key];
-    value += x;
+  void add_to_key(const StorageT& key, const CoeffT& x) {
+    CoeffT& value = data_[key];
+    value = coeff_add(value, x);
     if (value == 0) {
       data_.erase(key);
     }
   }
-  std::pair<ObjectT, int> element() const {
+  std::pair<ObjectT, CoeffT> element() const {
     auto key_coeff = element_key();
     return {ParamT::key_to_object(key_coeff.first), key_coeff.second};
   }
-  std::pair<StorageT, int> element_key() const {
+  std::pair<StorageT, CoeffT> element_key() const {
     return *data_.begin();
   }
-  std::pair<ObjectT, int> pop() {
+  std::pair<ObjectT, CoeffT> pop() {
     auto key_coeff = pop_key();
     return {ParamT::key_to_object(key_coeff.first), key_coeff.second};
   }
-  std::pair<StorageT, int> pop_key() {
+  std::pair<StorageT, CoeffT> pop_key() {
     auto ret = std::move(*data_.begin());
     data_.erase(data_.begin());
     return ret;
@@ -359,7 +394,7 @@ public:
 
   template<typename F>
   void foreach(F func) const {
-    foreach_key([&func](const auto& key, int coeff) {
+    foreach_key([&func](const auto& key, const CoeffT& coeff) {
       func(ParamT::key_to_object(key), coeff);
     });
   }
@@ -393,7 +428,7 @@ public:
   template<typename NewBasicLinearT, typename F>
   NewBasicLinearT mapped(F func) const {
     NewBasicLinearT ret;
-    foreach([&](const auto& obj, int coeff) {
+    foreach([&](const auto& obj, const CoeffT& coeff) {
       ret.add_to(func(obj), coeff);
     });
     return ret;
@@ -406,7 +441,7 @@ public:
   template<typename NewBasicLinearT, typename F>
   NewBasicLinearT mapped_key(F func) const {
     NewBasicLinearT ret;
-    foreach_key([&](const auto& key, int coeff) {
+    foreach_key([&](const auto& key, const CoeffT& coeff) {
       ret.add_to_key(func(key), coeff);
     });
     return ret;
@@ -420,34 +455,38 @@ public:
   auto mapped_expanding(F func) const {
     using ResultT = std::decay_t<std::invoke_result_t<F, ObjectT>>;
     static_assert(is_basic_linear_v<ResultT>, "mapped_expanding functor must return a BasicLinear expression");
-    ResultT ret;
-    foreach([&](const auto& obj, int coeff) {
-      ret += coeff * func(obj);
+    typename ResultT::Accumulator acc;
+    foreach([&](const auto& obj, const CoeffT& coeff) {
+      acc.add_expr(func(obj), typename ResultT::CoeffT(coeff));
     });
-    return ret;
+    return acc.materialize();
   }
   template<typename F>
   auto mapped_key_expanding(F func) const {
     using ResultT = std::decay_t<std::invoke_result_t<F, StorageT>>;
     static_assert(is_basic_linear_v<ResultT>, "mapped_expanding functor must return a BasicLinear expression");
-    ResultT ret;
-    foreach_key([&](const auto& key, int coeff) {
-      ret += coeff * func(key);
+    typename ResultT::Accumulator acc;
+    foreach_key([&](const auto& key, const CoeffT& coeff) {
+      acc.add_expr(func(key), typename ResultT::CoeffT(coeff));
     });
-    return ret;
+    return acc.materialize();
   }
 
   template<typename NewBasicLinearT>
   NewBasicLinearT cast_to() const {
     static_assert(is_basic_linear_v<NewBasicLinearT>);
     static_assert(std::is_same_v<typename NewBasicLinearT::StorageT, StorageT>);
-    return NewBasicLinearT(data_);
+    if constexpr (std::is_same_v<typename NewBasicLinearT::ContainerT, ContainerT>) {
+      return NewBasicLinearT(data_);
+    } else {
+      return NewBasicLinearT(typename NewBasicLinearT::ContainerT(data_.begin(), data_.end()));
+    }
   }
 
   template<typename F>
   BasicLinear filtered(F func) const {
     BasicLinear ret;
-    foreach_key([&](const auto& key, int coeff) {
+    foreach_key([&](const auto& key, const CoeffT& coeff) {
       if (func(ParamT::key_to_object(key))) {
         ret.add_to_key(key, coeff);
       }
@@ -457,7 +496,7 @@ public:
   template<typename F>
   BasicLinear filtered_key(F func) const {
     BasicLinear ret;
-    foreach_key([&](const auto& key, int coeff) {
+    foreach_key([&](const auto& key, const CoeffT& coeff) {
       if (func(key)) {
         ret.add_to_key(key, coeff);
       }
@@ -467,8 +506,8 @@ public:
 
   BasicLinear termwise_abs() const {
     BasicLinear ret;
-    foreach_key([&](const auto& key, int coeff) {
-      ret.add_to_key(key, std::abs(coeff));
+    foreach_key([&](const auto& key, const CoeffT& coeff) {
+      ret.add_to_key(key, coeff_abs(coeff));
     });
     return ret;
   }
@@ -503,12 +542,12 @@ public:
     ret -= other;
     return ret;
   }
-  BasicLinear operator*(int scalar) const {
+  BasicLinear operator*(const CoeffT& scalar) const {
     BasicLinear ret = *this;
     ret *= scalar;
     return ret;
   }
-  BasicLinear dived_int(int scalar) const {
+  BasicLinear dived_int(const CoeffT& scalar) const {
     BasicLinear ret = *this;
     ret.div_int(scalar);
     return ret;
@@ -522,25 +561,25 @@ public:
   }
   BasicLinear& operator-=(const BasicLinear& other) {
     for (const auto& [key, coeff]: other.data_) {
-      add_to_key(key, -coeff);
+      add_to_key(key, coeff_neg(coeff));
     }
     return *this;
   }
-  BasicLinear& operator*=(int scalar) {
+  BasicLinear& operator*=(const CoeffT& scalar) {
     if (scalar == 0) {
       *this = BasicLinear();
     } else {
       for (auto& [key, coeff]: data_) {
-        coeff *= scalar;
+        coeff = coeff_mul(coeff, scalar);
         ASSERT(coeff != 0);
       }
     }
     return *this;
   }
-  void div_int(int scalar) {
+  void div_int(const CoeffT& scalar) {
     CHECK(scalar != 0);
     for (auto& [key, coeff]: data_) {
-      coeff = ::div_int(coeff, scalar);
+      coeff = coeff_div(coeff, scalar);
       ASSERT(coeff != 0);
     }
   }
@@ -558,26 +597,75 @@ private:
   ContainerT data_;
 };
 
-template<typename ParamT>
-BasicLinear<ParamT> operator*(int scalar, const BasicLinear<ParamT>& linear) {
+template<typename ParamT, typename AllocatorT>
+BasicLinear<ParamT, AllocatorT> operator*(
+    const typename BasicLinear<ParamT, AllocatorT>::CoeffT& scalar,
+    const BasicLinear<ParamT, AllocatorT>& linear) {
   return linear * scalar;
 }
 
-template<typename ParamT, typename CompareF, typename ToStringF>
+// Expression with all memory allocated in the current `ScopedArena`. Must not outlive the arena.
+template<typename ParamT>
+using ArenaBasicLinear = BasicLinear<
+  ParamT,
+  ArenaAllocator<std::pair<const typename ParamT::StorageT, linear_coeff_t<ParamT>>>
+>;
+
+// Collects terms for an expression that is built in bulk, e.g. a product or a large sum.
+// Equivalent to calling `add_to_key` on a `BasicLinear`, but cheaper:
+//   * `add_expr(expr, c)` adds `c * expr` without creating a temporary expression;
+//   * terms that cancel out are not erased one by one; zero terms are dropped once, in
+//     `materialize`, which also saves a second hash map lookup per cancellation.
+template<typename ParamT, typename AllocatorT>
+class LinearAccumulator {
+public:
+  using Param = ParamT;
+  using StorageT = typename ParamT::StorageT;
+  using CoeffT = linear_coeff_t<ParamT>;
+  using ResultT = BasicLinear<ParamT, AllocatorT>;
+
+  bool empty() const { return data_.empty(); }
+  void reserve(int num_terms) { data_.reserve(num_terms); }
+
+  void add_to_key(const StorageT& key, const CoeffT& coeff) {
+    CoeffT& value = data_[key];
+    value = coeff_add(value, coeff);
+  }
+  // Adds `coeff * expr`.
+  template<typename LinearT>
+  void add_expr(const LinearT& expr, const CoeffT& coeff) {
+    static_assert(is_basic_linear_v<LinearT>);
+    expr.foreach_key([&](const StorageT& key, const auto& expr_coeff) {
+      add_to_key(key, coeff_mul(CoeffT(expr_coeff), coeff));
+    });
+  }
+
+  // Returns the sum of all terms added so far and clears the accumulator.
+  ResultT materialize() {
+    ResultT ret(std::move(data_));
+    data_.clear();
+    return ret;
+  }
+
+private:
+  typename ResultT::ContainerT data_;
+};
+
+template<typename ParamT, typename AllocatorT, typename CompareF, typename ToStringF>
 std::ostream& to_ostream(
     std::ostream& os,
-    const BasicLinear<ParamT>& linear,
+    const BasicLinear<ParamT, AllocatorT>& linear,
     const CompareF& sorting_cmp,
     const ToStringF& object_to_string) {
   const bool compact_expression = *current_formatting_config().compact_expression;
   const int line_limit = *current_formatting_config().expression_line_limit;
-  std::vector<std::pair<typename ParamT::ObjectT, int>> dump;
+  std::vector<std::pair<typename ParamT::ObjectT, int64_t>> dump;
   int max_coeff_length = 0;
-  linear.foreach([&](const auto& obj, int coeff) {
-    dump.push_back({obj, coeff});
+  linear.foreach([&](const auto& obj, const auto& coeff) {
+    dump.push_back({obj, coeff_for_printing(coeff)});
     // TODO: Use "figure space" (U+2007) for Unicode.
     if (!compact_expression) {
-      max_coeff_length = std::max<int>(max_coeff_length, strlen_utf8(fmt::coeff(coeff)));
+      max_coeff_length = std::max<int>(max_coeff_length, strlen_utf8(fmt::coeff(dump.back().second)));
     }
   });
   std::sort(dump.begin(), dump.end(), [&](const auto& a, const auto& b) {
@@ -610,8 +698,8 @@ std::ostream& to_ostream(
   return os;
 }
 
-template<typename ParamT>
-std::ostream& operator<<(std::ostream& os, const BasicLinear<ParamT>& linear) {
+template<typename ParamT, typename AllocatorT>
+std::ostream& operator<<(std::ostream& os, const BasicLinear<ParamT, AllocatorT>& linear) {
   return to_ostream(os, linear, std::less<>{}, &ParamT::object_to_string);
 }
 
@@ -641,6 +729,7 @@ public:
   using Param = ParamT;
   using ObjectT = typename ParamT::ObjectT;
   using StorageT = typename ParamT::StorageT;
+  using CoeffT = linear_coeff_t<ParamT>;
   using Basic = BasicLinear<ParamT>;
   using BasicLinearMain = BasicLinear<ParamT>;  // TODO: Delete
   using const_iterator = typename BasicLinearMain::const_iterator;
@@ -675,7 +764,7 @@ public:
   bool is_blank() const { return main_.is_zero() && annotations_.empty(); }
   int num_terms() const { return main_.num_terms(); }
   int l0_norm() const { return main_.l0_norm(); }
-  int l1_norm() const { return main_.l1_norm(); }
+  auto l1_norm() const { return main_.l1_norm(); }
   int weight() const { return main_.weight(); }
   int dimension() const { return main_.dimension(); }
   auto uniformity_marker() const { return main_.uniformity_marker(); }
@@ -685,14 +774,14 @@ public:
   const_iterator begin() const { return main_.begin(); }
   const_iterator end() const { return main_.end(); }
 
-  int operator[](const ObjectT& obj) const { return main_[obj]; }
-  int coeff_for_key(const StorageT& key) const { return main_.coeff_for_key(key); }
-  void add_to(const ObjectT& obj, int x) { return main_.add_to(obj, x); }
-  void add_to_key(const StorageT& key, int x)  { return main_.add_to_key(key, x); }
-  std::pair<ObjectT, int> element() const { return main_.element(); }
-  std::pair<StorageT, int> element_key() const { return main_.element_key(); }
-  std::pair<ObjectT, int> pop() { return main_.pop(); }
-  std::pair<StorageT, int> pop_key() { return main_.pop_key(); }
+  CoeffT operator[](const ObjectT& obj) const { return main_[obj]; }
+  CoeffT coeff_for_key(const StorageT& key) const { return main_.coeff_for_key(key); }
+  void add_to(const ObjectT& obj, const CoeffT& x) { return main_.add_to(obj, x); }
+  void add_to_key(const StorageT& key, const CoeffT& x)  { return main_.add_to_key(key, x); }
+  std::pair<ObjectT, CoeffT> element() const { return main_.element(); }
+  std::pair<StorageT, CoeffT> element_key() const { return main_.element_key(); }
+  std::pair<ObjectT, CoeffT> pop() { return main_.pop(); }
+  std::pair<StorageT, CoeffT> pop_key() { return main_.pop_key(); }
 
   template<typename F>
   void foreach(F func) const { return main_.foreach(func); }
@@ -731,20 +820,33 @@ public:
   auto mapped_expanding(F func) const {
     using ResultT = std::decay_t<std::invoke_result_t<F, ObjectT>>;
     static_assert(is_linear_v<ResultT>, "mapped_expanding functor must return a Linear expression");
-    ResultT ret;
-    foreach([&](const auto& obj, int coeff) {
-      ret += coeff * func(obj);
+    return mapped_key_expanding([&](const StorageT& key) {
+      return func(ParamT::key_to_object(key));
     });
-    return ret.copy_annotations(*this);
   }
   template<typename F>
   auto mapped_key_expanding(F func) const {
     using ResultT = std::decay_t<std::invoke_result_t<F, StorageT>>;
     static_assert(is_linear_v<ResultT>, "mapped_expanding functor must return a Linear expression");
+    // Terms without annotations go through the accumulator. Merging annotations depends on
+    // whether the sum so far is zero, so once annotations appear the sum is materialized and
+    // the rest is added one by one.
     ResultT ret;
-    foreach_key([&](const auto& key, int coeff) {
-      ret += coeff * func(key);
+    typename ResultT::Basic::Accumulator acc;
+    foreach_key([&](const auto& key, const CoeffT& coeff) {
+      const ResultT term = func(key);
+      if (term.annotations().empty() && ret.annotations().empty()) {
+        acc.add_expr(term.main(), typename ResultT::CoeffT(coeff));
+      } else {
+        if (!acc.empty()) {
+          ret += ResultT(acc.materialize());
+        }
+        ret += coeff * term;
+      }
     });
+    if (!acc.empty()) {
+      ret += ResultT(acc.materialize());
+    }
     return ret.copy_annotations(*this);
   }
 
@@ -767,7 +869,8 @@ public:
     return Linear(main_.termwise_abs(), annotations_);
   }
 
-  const BasicLinearMain& main() const { return main_; };
+  const BasicLinearMain& main() const& { return main_; };
+  BasicLinearMain main() && { return std::move(main_); };
   const LinearAnnotation& annotations() const { return annotations_; };
 
   // TODO: In order to make things less error-prone, split into:
@@ -819,12 +922,12 @@ public:
     ret -= other;
     return ret;
   }
-  Linear operator*(int scalar) const {
+  Linear operator*(const CoeffT& scalar) const {
     Linear ret = *this;
     ret *= scalar;
     return ret;
   }
-  Linear dived_int(int scalar) const {
+  Linear dived_int(const CoeffT& scalar) const {
     Linear ret = *this;
     ret.div_int(scalar);
     return ret;
@@ -840,15 +943,25 @@ public:
     add_annotations(other, -1, std::identity{});
     return *this;
   }
-  Linear& operator*=(int scalar) {
+  Linear& operator*=(const CoeffT& scalar) {
     main_ *= scalar;
-    annotations_.expression *= scalar;
+    // Annotations always have `int` coefficients.
+    if (const auto annotation_scalar = coeff_to_int<int>(scalar)) {
+      annotations_.expression *= *annotation_scalar;
+    } else {
+      annotations_ = {{}, {"Coefficient overflow"}};
+    }
     return *this;
   }
-  void div_int(int scalar) {
+  void div_int(const CoeffT& scalar) {
     main_.div_int(scalar);
+    const auto annotation_scalar = coeff_to_int<int>(scalar);
+    if (!annotation_scalar.has_value()) {
+      annotations_ = {{}, {"Coefficient overflow"}};
+      return;
+    }
     try {
-      annotations_.expression.div_int(scalar);
+      annotations_.expression.div_int(*annotation_scalar);
     } catch (IntegerDivisionError error) {
       annotations_ = {{}, {error.what()}};
     }
@@ -893,7 +1006,7 @@ private:
 };
 
 template<typename ParamT>
-Linear<ParamT> operator*(int scalar, const Linear<ParamT>& linear) {
+Linear<ParamT> operator*(const typename Linear<ParamT>::CoeffT& scalar, const Linear<ParamT>& linear) {
   return linear * scalar;
 }
 
@@ -928,7 +1041,7 @@ std::ostream& to_ostream(
   if (!linear.is_zero()) {
     const int num_terms = linear.num_terms();
     os << "# " << num_terms << " " << en_plural(num_terms, "term");
-    os << ", |coeff| = " << linear.l1_norm();
+    os << ", |coeff| = " << coeff_for_printing(linear.l1_norm());
     if (line_limit > 0) {
       os << ":" << fmt::newline();
       to_ostream(os, linear.main(), sorting_cmp, object_to_string);
@@ -980,7 +1093,7 @@ std::ostream& to_ostream_grouped(
     return os;
   }
   std::map<GroupT, LinearT, GroupCompareF> groups(group_sorting_cmp);
-  linear.foreach([&](const auto& term, int coeff) {
+  linear.foreach([&](const auto& term, const auto& coeff) {
     groups[group_by(term)].add_to(term, coeff);
   });
   bool first = true;
@@ -1,5 +1,10 @@
 #include "lyndon.h"
 
+#include <atomic>
+#include <memory>
+
+#include "call_cache.h"
+
 
 // Optimization potential: Cache (remember about thread-safety!)
 std::vector<std::vector<int>> get_lyndon_words(int alphabet_size, int length) {
@@ -33,3 +38,77 @@ std::vector<std::vector<int>> get_lyndon_words(int alphabet_size, int length) {
   }
   return words;
 }
+
+
+static std::atomic<bool> lyndon_memo_flag = true;
+
+bool lyndon_memo_enabled() {
+  return lyndon_memo_flag;
+}
+
+void set_lyndon_memo_enabled(bool enabled) {
+  lyndon_memo_flag = enabled;
+}
+
+static constexpr size_t kLyndonMemoDefaultMaxBytes = size_t(256) << 20;
+
+// Key: shape packed together with word length.
+static CallCache<std::shared_ptr<const internal::LyndonShapeExpansion>, uint64_t>& lyndon_memo() {
+  static CallCache<std::shared_ptr<const internal::LyndonShapeExpansion>, uint64_t> cache(
+    kLyndonMemoDefaultMaxBytes
+  );
+  return cache;
+}
+
+void set_lyndon_memo_max_bytes(size_t max_bytes) {
+  lyndon_memo().set_max_bytes(max_bytes);
+}
+
+void clear_lyndon_memo() {
+  lyndon_memo().clear();
+}
+
+
+namespace internal {
+
+static constexpr int kLyndonShapeLengthShift = kMaxLyndonMemoWordLength * kLyndonShapeLetterBits;
+static_assert(kLyndonShapeLengthShift + 8 <= 64);
+
+static std::vector<int> unpack_lyndon_shape(LyndonShape shape, int length) {
+  return mapped(range(length), [&](int pos) -> int {
+    const int shift = (length - pos - 1) * kLyndonShapeLetterBits;
+    return (shape >> shift) & ((1 << kLyndonShapeLetterBits) - 1);
+  });
+}
+
+static LyndonShape pack_lyndon_shape(const std::vector<int>& word) {
+  LyndonShape shape = 0;
+  for (const int letter : word) {
+    shape = (shape << kLyndonShapeLetterBits) | letter;
+  }
+  return shape;
+}
+
+static LyndonShapeExpansion compute_lyndon_shape_expansion(LyndonShape shape, int length) {
+  using ShapeExpr = BasicLinear<SimpleLinearParam<std::vector<int>>>;
+  const auto expansion = to_lyndon_basis_queue(
+    ShapeExpr::single(unpack_lyndon_shape(shape, length)),
+    std::less<int>{}
+  );
+  LyndonShapeExpansion ret;
+  ret.reserve(expansion.num_terms());
+  expansion.foreach_key([&](const std::vector<int>& word, int coeff) {
+    ret.push_back({pack_lyndon_shape(word), coeff});
+  });
+  return ret;
+}
+
+std::shared_ptr<const LyndonShapeExpansion> lyndon_shape_expansion(LyndonShape shape, int length) {
+  CHECK_LE(length, kMaxLyndonMemoWordLength);
+  const uint64_t key = shape | (uint64_t(length) << kLyndonShapeLengthShift);
+  return lyndon_memo().apply([&](uint64_t) {
+    return std::make_shared<const LyndonShapeExpansion>(compute_lyndon_shape_expansion(shape, length));
+  }, key);
+}
+
+}  // namespace internal
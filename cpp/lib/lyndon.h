@@ -1,12 +1,14 @@
 #pragma once
 
+#include <memory>
+
 #include "compare.h"
 #include "linear.h"
+#include "merging_heap.h"
+#include "parallel_util.h"
 #include "shuffle.h"
 #include "util.h"
 
-#include "absl/container/btree_map.h"
-
 
 std::vector<std::vector<int>> get_lyndon_words(int alphabet_size, int length);
 
@@ -58,50 +60,32 @@ auto lyndon_factorize(const Container& word) {
   return lyndon_factorize(word, std::less<void>{});
 }
 
-// Converts a linear combination of words to Lyndon basis.
-//
-// Algorithm. Put expression terms into a priority queue, largest term first.
-// Since shuffle equation for Lyndon factorization always produces smaller words
-// than the original word, this guarantees we'll process every word only once.
-// For each term in the queue:
-//   * If the term is already a Lyndon word, move it to the list of known Lyndon
-//     words.
-//   * If the term is not a Lyndon word, factorize it into Lyndon words and apply
-//     shuffle equation. Replace the term with shuffle result. Put known Lyndon
-//     words directly to Lyndon words list - no need to process them again. Put
-//     everything else into the common queue.
-// Continue until the queue is empty. Now the list of known Lyndon words contains
-// entire expression in Lyndon basis.
-//
-// Optimization potential: Unroll Lyndon for words of 3-4 characters (consider
-//   autogeneration, as for shuffle).
-// Optimization potential: In case of words of 1-2 characters there is no need
-//   to build the priority queue. In order to keep the ability to compute Lyndon
-//   basis for a mixed-weight expression, we could check length when filling the
-//   queue.
-template<typename LinearT>
-std::enable_if_t<is_basic_linear_v<LinearT>, LinearT>
-to_lyndon_basis(const LinearT& expression) {
-  auto expr = to_vector_expression(expression);
-  using VectorLinearT = decltype(expr);
+// Lyndon basis memoization (see `to_lyndon_basis`). Enabled by default. The setting is global.
+bool lyndon_memo_enabled();
+void set_lyndon_memo_enabled(bool enabled);
+// Limits the estimated size of memoized expansions (256 MiB by default); zero means no limit.
+// Least recently used expansions are evicted first.
+void set_lyndon_memo_max_bytes(size_t max_bytes);
+// Drops all memoized expansions.
+void clear_lyndon_memo();
+
+namespace internal {
+template<typename VectorLinearT, typename CompareT>
+VectorLinearT to_lyndon_basis_queue(const VectorLinearT& expr, const CompareT& lyndon_compare) {
   using VectorT = typename VectorLinearT::Param::StorageT;
-  // Optimization potential: Replace the map with a heap.
-  //   Note: std::make_heap and std::pop_heap can be used as-is, but std::push_heap
-  //   needs to be replaced with a custom implementation that supports data merges.
-  struct MapCompare {
-    bool operator()(const VectorT& lhs, const VectorT& rhs) const {
-      return absl::c_lexicographical_compare(lhs, rhs, cmp::greater_from_less(&LinearT::Param::lyndon_compare));
-    }
-  };
-  absl::btree_map<VectorT, int, MapCompare> terms_to_convert{
-    expr.data().begin(),
-    expr.data().end(),
+  using CoeffT = typename VectorLinearT::CoeffT;
+  const auto heap_compare = [&](const VectorT& lhs, const VectorT& rhs) {
+    return absl::c_lexicographical_compare(lhs, rhs, lyndon_compare);
   };
+  MergingHeap<VectorT, CoeffT, decltype(heap_compare)> terms_to_convert(heap_compare);
+  terms_to_convert.reserve(expr.num_terms());
+  for (const auto& [word, coeff] : expr.data()) {
+    terms_to_convert.push(word, coeff);
+  }
   VectorLinearT terms_converted;
 
   while (!terms_to_convert.empty()) {
-    const auto [word, coeff] = *terms_to_convert.begin();
-    terms_to_convert.erase(terms_to_convert.begin());
+    const auto [word, coeff] = terms_to_convert.pop();
     if (coeff == 0) {
       continue;
     }
@@ -110,9 +94,9 @@ to_lyndon_basis(const LinearT& expression) {
       terms_converted.add_to_key(word, coeff);
       continue;
     } else if (word.size() == 2) {
-      if (LinearT::Param::lyndon_compare(word[0], word[1])) {
+      if (lyndon_compare(word[0], word[1])) {
         terms_converted.add_to_key(word, coeff);
-      } else if (LinearT::Param::lyndon_compare(word[1], word[0])) {
+      } else if (lyndon_compare(word[1], word[0])) {
         terms_converted.add_to_key({word[1], word[0]}, -coeff);
       } else {
         // though away: zero
@@ -120,30 +104,127 @@ to_lyndon_basis(const LinearT& expression) {
       continue;
     }
 
-    const auto& lyndon_words = lyndon_factorize(word, &LinearT::Param::lyndon_compare);
+    const auto& lyndon_words = lyndon_factorize(word, lyndon_compare);
     CHECK(!lyndon_words.empty());
     if (lyndon_words.size() == 1) {
       terms_converted.add_to_key(word, coeff);
       continue;
     }
 
-    const auto& lyndon_expr = VectorLinearT::from_key_collection(lyndon_words);
+    // Temporary expressions live only until the end of this iteration.
+    ScopedArena arena;
+    using ArenaVectorLinearT = ArenaBasicLinear<typename VectorLinearT::Param>;
+    const auto& lyndon_expr = ArenaVectorLinearT::from_key_collection(lyndon_words);
     int denominator = 1;
-    lyndon_expr.foreach_key([&denominator](const auto&, int coeff) {
-      denominator *= factorial(coeff);
+    lyndon_expr.foreach_key([&denominator](const auto&, const auto& count) {
+      const auto count_int = coeff_to_int<int>(count);
+      ASSERT(count_int.has_value());
+      denominator *= factorial(*count_int);
     });
 
-    auto shuffle_expr = shuffle_product(lyndon_words).template cast_to<VectorLinearT>();
+    auto shuffle_expr = internal::shuffle_product_impl<ArenaVectorLinearT>(lyndon_words);
     shuffle_expr.div_int(denominator);
     CHECK_EQ(shuffle_expr.coeff_for_key(word), 1);
     shuffle_expr.add_to_key(word, -1);
     for (const auto& [key, inner_coeff] : key_view(shuffle_expr)) {
       ASSERT(terms_converted.coeff_for_key(key) == 0);
-      terms_to_convert[key] -= coeff * inner_coeff;
+      terms_to_convert.push(key, -coeff * inner_coeff);
     }
   };
 
-  return from_vector_expression<LinearT>(terms_converted);
+  return terms_converted;
+}
+
+// Word shape: letters replaced by their ranks among the distinct letters of the word, with
+// respect to `lyndon_compare`. E.g. "cacb" -> "2021". Lyndon basis conversion only depends on
+// letter comparison, so the expansion of a word can be obtained from the expansion of its shape
+// by substituting the letters back. Shapes are packed into integers, `kLyndonShapeLetterBits`
+// per letter, first letter in the highest bits.
+using LyndonShape = uint64_t;
+using LyndonShapeExpansion = std::vector<std::pair<LyndonShape, int>>;
+
+inline constexpr int kLyndonShapeLetterBits = 4;
+inline constexpr int kMaxLyndonMemoWordLength = 12;
+
+// Returns the expansion of a word of the given shape in Lyndon basis. Results are cached
+// (the cache is thread-safe, shared by all alphabets and bounded, see `set_lyndon_memo_max_bytes`).
+std::shared_ptr<const LyndonShapeExpansion> lyndon_shape_expansion(LyndonShape shape, int length);
+
+template<typename VectorLinearT, typename CompareT>
+VectorLinearT to_lyndon_basis_memoized(const VectorLinearT& expr, const CompareT& lyndon_compare) {
+  using VectorT = typename VectorLinearT::Param::StorageT;
+  using LetterT = typename VectorT::value_type;
+  VectorLinearT ret;
+  VectorLinearT too_long;
+  std::vector<LetterT> letters;
+  for (const auto& [word, coeff] : expr.data()) {
+    const int length = word.size();
+    if (length > kMaxLyndonMemoWordLength) {
+      too_long.add_to_key(word, coeff);
+      continue;
+    }
+    letters.assign(word.begin(), word.end());
+    absl::c_sort(letters, lyndon_compare);
+    letters.erase(std::unique(letters.begin(), letters.end()), letters.end());
+    LyndonShape shape = 0;
+    for (const auto& letter : word) {
+      const int rank = absl::c_lower_bound(letters, letter, lyndon_compare) - letters.begin();
+      shape = (shape << kLyndonShapeLetterBits) | rank;
+    }
+    VectorT new_word = word;
+    const auto expansion = lyndon_shape_expansion(shape, length);
+    for (const auto& [new_shape, shape_coeff] : *expansion) {
+      for (const int pos : range(length)) {
+        const int shift = (length - pos - 1) * kLyndonShapeLetterBits;
+        new_word[pos] = letters[(new_shape >> shift) & ((1 << kLyndonShapeLetterBits) - 1)];
+      }
+      ret.add_to_key(new_word, coeff_mul(coeff, typename VectorLinearT::CoeffT(shape_coeff)));
+    }
+  }
+  if (!too_long.is_zero()) {
+    ret += to_lyndon_basis_queue(too_long, lyndon_compare);
+  }
+  return ret;
+}
+
+template<typename VectorLinearT, typename CompareT>
+VectorLinearT to_lyndon_basis_vector(const VectorLinearT& expr, const CompareT& lyndon_compare) {
+  return lyndon_memo_enabled()
+    ? to_lyndon_basis_memoized(expr, lyndon_compare)
+    : to_lyndon_basis_queue(expr, lyndon_compare);
+}
+}  // namespace internal
+
+// Converts a linear combination of words to Lyndon basis.
+//
+// Algorithm. Put expression terms into a priority queue (`MergingHeap`), largest term first.
+// Since shuffle equation for Lyndon factorization always produces smaller words
+// than the original word, this guarantees we'll process every word only once.
+// For each term in the queue:
+//   * If the term is already a Lyndon word, move it to the list of known Lyndon
+//     words.
+//   * If the term is not a Lyndon word, factorize it into Lyndon words and apply
+//     shuffle equation. Replace the term with shuffle result. Put known Lyndon
+//     words directly to Lyndon words list - no need to process them again. Put
+//     everything else into the common queue.
+// Continue until the queue is empty. Now the list of known Lyndon words contains
+// entire expression in Lyndon basis.
+//
+// Memoization. Unless disabled via `set_lyndon_memo_enabled`, the algorithm above is applied
+// once per word shape (see `internal::LyndonShape`) rather than to the expression itself. The
+// expansion of each term is then obtained by substituting its letters into the memoized shape
+// expansion. Words longer than `kMaxLyndonMemoWordLength` always go through the queue.
+//
+// Optimization potential: In case of words of 1-2 characters there is no need
+//   to build the priority queue. In order to keep the ability to compute Lyndon
+//   basis for a mixed-weight expression, we could check length when filling the
+//   queue.
+template<typename LinearT>
+std::enable_if_t<is_basic_linear_v<LinearT>, LinearT>
+to_lyndon_basis(const LinearT& expression) {
+  return from_vector_expression<LinearT>(
+    internal::to_lyndon_basis_vector(to_vector_expression(expression), &LinearT::Param::lyndon_compare)
+  );
 }
 
 template<typename LinearT>
@@ -151,3 +232,55 @@ std::enable_if_t<is_linear_v<LinearT>, LinearT>
 to_lyndon_basis(const LinearT& expression) {
   return to_lyndon_basis(expression.main()).copy_annotations(expression);
 }
+
+// Same as `to_lyndon_basis`, but runs on multiple threads. Lyndon basis conversion preserves
+// the multiset of letters of each word, so terms with different multisets never interact. Terms
+// are split into shards by an order-independent hash of the letters, and each shard is converted
+// independently. Non-positive `num_threads` means hardware concurrency.
+template<typename LinearT>
+std::enable_if_t<is_basic_linear_v<LinearT>, LinearT>
+to_lyndon_basis_parallel(const LinearT& expression, int num_threads = 0) {
+  static constexpr int kShardsPerThread = 4;
+  static constexpr int kMinTermsPerShard = 256;
+  const auto expr = to_vector_expression(expression);
+  using VectorLinearT = std::decay_t<decltype(expr)>;
+  using LetterT = typename VectorLinearT::Param::StorageT::value_type;
+  const auto lyndon_compare = &LinearT::Param::lyndon_compare;
+  const int num_shards = std::min(
+    resolve_num_threads(num_threads) * kShardsPerThread,
+    expr.num_terms() / kMinTermsPerShard
+  );
+  if (num_shards <= 1) {
+    return to_lyndon_basis(expression);
+  }
+
+  std::vector<VectorLinearT> shards(num_shards);
+  for (const auto& [word, coeff] : expr.data()) {
+    size_t hash = 0;
+    for (const auto& letter : word) {
+      hash += absl::Hash<LetterT>{}(letter);
+    }
+    shards[hash % num_shards].add_to_key(word, coeff);
+  }
+  // Largest shards first, see `parallel_for_work_stealing`.
+  std::vector<int> order = to_vector(range(num_shards));
+  absl::c_sort(order, [&](int a, int b) { return shards[a].num_terms() > shards[b].num_terms(); });
+  parallel_for_work_stealing(num_shards, num_threads, [&](int task) {
+    auto& shard = shards[order[task]];
+    shard = internal::to_lyndon_basis_vector(shard, lyndon_compare);
+  });
+
+  VectorLinearT ret;
+  for (const auto& shard : shards) {
+    shard.foreach_key([&](const auto& word, const auto& coeff) {
+      ret.add_to_key(word, coeff);
+    });
+  }
+  return from_vector_expression<LinearT>(ret);
+}
+
+template<typename LinearT>
+std::enable_if_t<is_linear_v<LinearT>, LinearT>
+to_lyndon_basis_parallel(const LinearT& expression, int num_threads = 0) {
+  return to_lyndon_basis_parallel(expression.main(), num_threads).copy_annotations(expression);
+}
@@ -0,0 +1,114 @@
+#include "mapped_file.h"
+
+#include <utility>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "check.h"
+
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(const std::string& filename) {
+  file_handle_ = CreateFileA(
+    filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+    OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr
+  );
+  CHECK(file_handle_ != INVALID_HANDLE_VALUE) << "Cannot open " << filename;
+  LARGE_INTEGER file_size;
+  CHECK(GetFileSizeEx(file_handle_, &file_size)) << "Cannot get size of " << filename;
+  size_ = file_size.QuadPart;
+  if (size_ == 0) {
+    return;
+  }
+  mapping_handle_ = CreateFileMappingA(file_handle_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CHECK(mapping_handle_ != nullptr) << "Cannot map " << filename;
+  data_ = static_cast<const char*>(MapViewOfFile(mapping_handle_, FILE_MAP_READ, 0, 0, 0));
+  CHECK(data_ != nullptr) << "Cannot map " << filename;
+}
+
+void MappedFile::unmap() {
+  if (data_) {
+    UnmapViewOfFile(data_);
+  }
+  if (mapping_handle_) {
+    CloseHandle(mapping_handle_);
+  }
+  if (file_handle_ && file_handle_ != INVALID_HANDLE_VALUE) {
+    CloseHandle(file_handle_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+  file_handle_ = nullptr;
+  mapping_handle_ = nullptr;
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+  : data_(std::exchange(other.data_, nullptr)),
+    size_(std::exchange(other.size_, 0)),
+    file_handle_(std::exchange(other.file_handle_, nullptr)),
+    mapping_handle_(std::exchange(other.mapping_handle_, nullptr)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    unmap();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+    file_handle_ = std::exchange(other.file_handle_, nullptr);
+    mapping_handle_ = std::exchange(other.mapping_handle_, nullptr);
+  }
+  return *this;
+}
+
+#else  // POSIX
+
+MappedFile::MappedFile(const std::string& filename) {
+  const int fd = open(filename.c_str(), O_RDONLY);
+  CHECK(fd >= 0) << "Cannot open " << filename;
+  struct stat file_stat;
+  CHECK(fstat(fd, &file_stat) == 0) << "Cannot get size of " << filename;
+  size_ = file_stat.st_size;
+  if (size_ > 0) {
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    CHECK(data != MAP_FAILED) << "Cannot map " << filename;
+    // Files are normally read from the beginning to the end.
+    madvise(data, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(data);
+  }
+  // The mapping stays valid after the descriptor is closed.
+  close(fd);
+}
+
+void MappedFile::unmap() {
+  if (data_) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+  : data_(std::exchange(other.data_, nullptr)),
+    size_(std::exchange(other.size_, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    unmap();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+  unmap();
+}
@@ -0,0 +1,32 @@
+// Read-only memory-mapped file. Allows to work with files that are larger than RAM: the pages
+// are loaded by the OS on demand and can be evicted at any time.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+
+class MappedFile {
+public:
+  explicit MappedFile(const std::string& filename);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  void unmap();
+
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+#if defined(_WIN32)
+  void* file_handle_ = nullptr;
+  void* mapping_handle_ = nullptr;
+#endif
+};
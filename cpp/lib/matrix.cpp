@@ -1,9 +1,11 @@
 #include "matrix.h"
 
+#include <cctype>
+#include <charconv>
 #include <fstream>
 
-#include "compare.h"
 #include "format.h"
+#include "mapped_file.h"
 #include "table_printer.h"
 #include "util.h"
 
@@ -49,35 +51,106 @@ Matrix Matrix::transposed() const {
 }
 
 
-MatrixView::MatrixView(const Matrix* matrix, ViewType view_type)
-    : matrix_(matrix), view_type_(view_type) {
-  CHECK(matrix_ != nullptr);
+CompressedMatrix::CompressedMatrix(int rows, int cols)
+  : col_offsets_(cols + 1, 0), row_offsets_(rows + 1, 0)
+{
+  CHECK_GE(rows, 0);
+  CHECK_GE(cols, 0);
 }
 
-std::vector<MatrixView::Triplet> MatrixView::as_triplets() const {
-  return mapped(
-    matrix_->as_triplets(), [&](const auto& t) {
-      return view_type_ == RowMajor
-          ? MatrixView::Triplet{t.row, t.col, t.value}
-          : MatrixView::Triplet{t.col, t.row, t.value};
+CompressedMatrix::CompressedMatrix(const Matrix& matrix)
+  : CompressedMatrix(from_triplets(matrix.shape(), matrix.as_triplets())) {}
+
+CompressedMatrix CompressedMatrix::from_sparse_cols(int rows, const std::vector<std::vector<Element>>& cols) {
+  CompressedMatrix ret(rows, cols.size());
+  ret.col_elements_.reserve(sum(cols, [](const auto& col) { return col.size(); }));
+  for (const int i_col : range(cols.size())) {
+    const auto begin = ret.col_elements_.size();
+    for (const auto& [row, value] : cols[i_col]) {
+      CHECK(0 <= row && row < rows) << row << " not in [0," << rows << ")";
+      if (value != 0) {
+        ret.col_elements_.push_back({row, value});
+      }
     }
-  );
+    const auto col_begin = ret.col_elements_.begin() + begin;
+    if (!std::is_sorted(col_begin, ret.col_elements_.end())) {
+      std::sort(col_begin, ret.col_elements_.end());
+    }
+    CHECK(std::adjacent_find(col_begin, ret.col_elements_.end(), [](const auto& a, const auto& b) {
+      return a.first == b.first;
+    }) == ret.col_elements_.end()) << "duplicate row in column " << i_col;
+    ret.col_offsets_[i_col + 1] = ret.col_elements_.size();
+  }
+  ret.build_rows(rows);
+  return ret;
+}
+
+CompressedMatrix CompressedMatrix::from_sparse_rows(int cols, const std::vector<std::vector<Element>>& rows) {
+  return from_sparse_cols(cols, rows).transposed();
+}
+
+CompressedMatrix CompressedMatrix::from_triplets(std::pair<int, int> shape, const std::vector<Triplet>& triplets) {
+  std::vector<std::vector<Element>> cols(shape.second);
+  for (const auto& t : triplets) {
+    CHECK(0 <= t.col && t.col < shape.second) << t.col << " not in [0," << shape.second << ")";
+    cols[t.col].push_back({t.row, t.value});
+  }
+  return from_sparse_cols(shape.first, cols);
+}
+
+// Elements of each column are sorted by row, so traversing columns in order produces rows
+// that are sorted by column.
+void CompressedMatrix::build_rows(int rows) {
+  row_offsets_.assign(rows + 1, 0);
+  for (const auto& [row, value] : col_elements_) {
+    ++row_offsets_[row + 1];
+  }
+  for (const int i : range(rows)) {
+    row_offsets_[i + 1] += row_offsets_[i];
+  }
+  row_elements_.resize(col_elements_.size());
+  std::vector<int> row_pos(row_offsets_.begin(), row_offsets_.end() - 1);
+  for (const int i_col : range(cols())) {
+    for (const auto& [row, value] : col(i_col)) {
+      row_elements_[row_pos[row]++] = {i_col, value};
+    }
+  }
+}
+
+std::vector<CompressedMatrix::Triplet> CompressedMatrix::as_triplets() const {
+  std::vector<Triplet> result;
+  result.reserve(num_nonzero());
+  for (const int i_row : range(rows())) {
+    for (const auto& [col, value] : row(i_row)) {
+      result.push_back({i_row, col, value});
+    }
+  }
+  return result;
+}
+
+Matrix CompressedMatrix::to_matrix() const {
+  Matrix ret(shape());
+  for (const auto& t : as_triplets()) {
+    ret(t.row, t.col) = t.value;
+  }
+  return ret;
+}
+
+CompressedMatrix CompressedMatrix::transposed() && {
+  std::swap(col_offsets_, row_offsets_);
+  std::swap(col_elements_, row_elements_);
+  return std::move(*this);
 }
 
 
 // Sorts vector of (row, val) or (col, val) pairs so that the resulting the order is what
 // it would be for a dense vector where missing elements are filled with zeros.
-static bool sparse_vector_less(
-  std::vector<std::pair<int, int>>& lhs,
-  std::vector<std::pair<int, int>>& rhs
-) {
+static bool sparse_vector_less(CompressedMatrix::Line lhs, CompressedMatrix::Line rhs) {
   const int inf = std::numeric_limits<int>::max();
   const int n = std::max(lhs.size(), rhs.size());
   for (const int i : range(n)) {
     const auto [lp, lv] = (i < lhs.size()) ? lhs[i] : std::pair{inf, 0};
     const auto [rp, rv] = (i < rhs.size()) ? rhs[i] : std::pair{inf, 0};
-    CHECK(lp == inf || lv != 0);
-    CHECK(rp == inf || rv != 0);
     if (lp < rp) {
       return lv < 0;
     } else if (lp > rp) {
@@ -89,39 +162,37 @@ static bool sparse_vector_less(
   return false;
 }
 
-Matrix sort_unique_rows(const Matrix& matrix) {
-  std::vector<std::vector<std::pair<int, int>>> rows(matrix.rows());
-  for (const auto& t : matrix.as_triplets()) {
-    rows[t.row].push_back({t.col, t.value});
-  }
-  for (auto& colvalues : rows) {
-    absl::c_sort(colvalues);
-  }
-  auto sorted_rows = sorted(rows, sparse_vector_less);
-  keep_unique_sorted(sorted_rows);
-  absl::flat_hash_map<std::pair<int, int>, int> triplets;
-  int row = 0;
-  for (const auto& colvalues : sorted_rows) {
-    for (const auto& [col, value] : colvalues) {
-      triplets[{row, col}] = value;
+CompressedMatrix sort_unique_rows(const CompressedMatrix& matrix) {
+  std::vector<int> row_order = to_vector(range(matrix.rows()));
+  absl::c_sort(row_order, [&](int a, int b) {
+    return sparse_vector_less(matrix.row(a), matrix.row(b));
+  });
+  std::vector<std::vector<CompressedMatrix::Element>> sorted_rows;
+  for (const int row : row_order) {
+    const auto line = matrix.row(row);
+    if (sorted_rows.empty() || !absl::c_equal(sorted_rows.back(), line)) {
+      sorted_rows.push_back(std::vector(line.begin(), line.end()));
     }
-    ++row;
   }
-  return Matrix(std::pair{row, matrix.cols()}, std::move(triplets));
+  return CompressedMatrix::from_sparse_rows(matrix.cols(), sorted_rows);
 }
 
-Matrix sort_unique_cols(const Matrix& matrix) {
+CompressedMatrix sort_unique_cols(const CompressedMatrix& matrix) {
   return sort_unique_rows(matrix.transposed()).transposed();
 }
 
-static std::string matrix_header(const Matrix& matrix) {
+static std::string matrix_header(const CompressedMatrix& matrix) {
   return absl::StrCat(
     matrix.rows(), "x", matrix.cols(), " matrix, ",
-    matrix.as_triplets().size(), " elements"
+    matrix.num_nonzero(), " elements"
   );
 }
 
 std::string to_string(const Matrix& matrix) {
+  return to_string(CompressedMatrix(matrix));
+}
+
+std::string to_string(const CompressedMatrix& matrix) {
   const int kMaxColumns = 16;
   const int kMaxRows = 16;
   const int kEllipsisSize = 3;
@@ -194,35 +265,73 @@ std::string to_string(const Matrix& matrix) {
 }
 
 std::string dump_to_string_impl(const Matrix& matrix) {
+  return dump_to_string_impl(CompressedMatrix(matrix));
+}
+
+std::string dump_to_string_impl(const CompressedMatrix& matrix) {
   return absl::StrCat("<", matrix_header(matrix), ">");
 }
 
-void save_triplets(const std::string& filename, const Matrix& matrix) {
+void save_triplets(const std::string& filename, const CompressedMatrix& matrix) {
   std::ofstream fs(filename);
   CHECK(fs.good());
   fs << matrix.rows() << " " << matrix.cols() << "\n";
-  fs << matrix.num_triplets() << "\n";
-  const auto triplets_sorted = sorted(
-    matrix.as_triplets(),
-    cmp::projected([](const auto& t) { return std::tie(t.row, t.col); })
-  );
-  for (const auto& t : triplets_sorted) {
+  fs << matrix.num_nonzero() << "\n";
+  for (const auto& t : matrix.as_triplets()) {
     fs << t.row << " " << t.col << " " << t.value << "\n";
   }
   CHECK(fs.good());
 }
 
-Matrix load_triplets(const std::string& filename) {
-  std::ifstream fs(filename);
-  int num_rows, num_cols, num_triplets;
-  CHECK(!!(fs >> num_rows >> num_cols >> num_triplets));
-  Matrix matrix(num_rows, num_cols);
-  for (EACH : range(num_triplets)) {
-    int row, col, value;
-    CHECK(!!(fs >> row >> col >> value));
-    matrix(row, col) = value;
-  }
-  return matrix;
+// Reads whitespace-separated integers from a memory-mapped file. This is an order of magnitude
+// faster than `std::ifstream::operator>>`, which matters for multi-gigabyte files.
+class IntTokenReader {
+public:
+  explicit IntTokenReader(const std::string& filename)
+    : file_(filename), ptr_(file_.data()), end_(file_.data() + file_.size()) {}
+
+  int next() {
+    while (ptr_ != end_ && std::isspace(static_cast<unsigned char>(*ptr_))) {
+      ++ptr_;
+    }
+    int value = 0;
+    const auto [ptr, ec] = std::from_chars(ptr_, end_, value);
+    CHECK(ec == std::errc()) << "Cannot parse integer at offset " << (ptr_ - file_.data());
+    ptr_ = ptr;
+    return value;
+  }
+
+private:
+  MappedFile file_;
+  const char* ptr_ = nullptr;
+  const char* end_ = nullptr;
+};
+
+CompressedMatrix load_triplets(const std::string& filename) {
+  IntTokenReader reader(filename);
+  const int num_rows = reader.next();
+  const int num_cols = reader.next();
+  const int num_triplets = reader.next();
+  std::vector<Matrix::Triplet> triplets(num_triplets);
+  for (auto& t : triplets) {
+    t.row = reader.next();
+    t.col = reader.next();
+    t.value = reader.next();
+    CHECK(0 <= t.row && t.row < num_rows) << t.row << " not in [0," << num_rows << ")";
+  }
+  // Keep the last value for duplicate elements. Stable sort preserves the order of duplicates.
+  std::stable_sort(triplets.begin(), triplets.end(), [](const auto& a, const auto& b) {
+    return std::pair(a.row, a.col) < std::pair(b.row, b.col);
+  });
+  auto out = triplets.begin();
+  for (auto it = triplets.begin(); it != triplets.end(); ++it) {
+    const auto next = std::next(it);
+    if (next == triplets.end() || next->row != it->row || next->col != it->col) {
+      *out++ = *it;
+    }
+  }
+  triplets.erase(out, triplets.end());
+  return CompressedMatrix::from_triplets({num_rows, num_cols}, triplets);
 }
 
 // TODO: Support loading compressed files.
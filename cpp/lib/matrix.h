@@ -4,11 +4,12 @@
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/types/span.h"
 
 #include "check.h"
 
 
-// Sparse integer matrix.
+// Sparse integer matrix that supports random access modification. See also `CompressedMatrix`.
 class Matrix {
 public:
   struct Triplet {
@@ -53,46 +54,84 @@ inline int& Matrix::operator()(int row, int col) {
 }
 
 
-class MatrixView {
+// Immutable sparse integer matrix in compressed form. Stores both compressed sparse columns
+// and compressed sparse rows, so that rows and columns can be iterated without copying.
+// Elements within each row and column are sorted by index. Zeros are never stored.
+//
+// Use this rather than `Matrix` for large matrices: it takes 16 bytes per element and
+// doesn't require sorting or hashing when traversed.
+class CompressedMatrix {
 public:
-  enum ViewType {
-    RowMajor,
-    ColumnMajor,
-  };
-
-  struct Triplet {
-    int a = 0;
-    int b = 0;
-    int value = 0;
-  };
-
-  MatrixView(const Matrix* matrix, ViewType view_type);
+  using Triplet = Matrix::Triplet;
+  using Element = std::pair<int, int>;  // (row, value) in a column or (col, value) in a row
+  using Line = absl::Span<const Element>;
+
+  CompressedMatrix() : CompressedMatrix(0, 0) {}
+  explicit CompressedMatrix(int rows, int cols);
+  explicit CompressedMatrix(std::pair<int, int> shape) : CompressedMatrix(shape.first, shape.second) {}
+  // Implicit: allows to pass `Matrix` wherever `CompressedMatrix` is expected.
+  CompressedMatrix(const Matrix& matrix);
+
+  // Each column must have unique row indices, but they don't need to be sorted.
+  static CompressedMatrix from_sparse_cols(int rows, const std::vector<std::vector<Element>>& cols);
+  // Each row must have unique col indices, but they don't need to be sorted.
+  static CompressedMatrix from_sparse_rows(int cols, const std::vector<std::vector<Element>>& rows);
+  // Each (row, col) pair must be unique.
+  static CompressedMatrix from_triplets(std::pair<int, int> shape, const std::vector<Triplet>& triplets);
+
+  int rows() const { return row_offsets_.size() - 1; }
+  int cols() const { return col_offsets_.size() - 1; }
+  std::pair<int, int> shape() const { return {rows(), cols()}; }
+  int num_nonzero() const { return col_elements_.size(); }
+
+  Line row(int idx) const { return line(row_offsets_, row_elements_, idx); }
+  Line col(int idx) const { return line(col_offsets_, col_elements_, idx); }
+
+  // In row-major order.
+  std::vector<Triplet> as_triplets() const;
+  Matrix to_matrix() const;
 
-  const Matrix* matrix() const { return matrix_; }
-  ViewType view_type() const { return view_type_; }
+  // O(1) if the matrix is an rvalue, otherwise O(num_nonzero).
+  CompressedMatrix transposed() const & { return CompressedMatrix(*this).transposed(); }
+  CompressedMatrix transposed() &&;
 
-  int a_size() const { return view_type_ == RowMajor ? matrix_->rows() : matrix_->cols(); }
-  int b_size() const { return view_type_ == RowMajor ? matrix_->cols() : matrix_->rows(); }
-  // Optimization potential: return a custom iterator instead.
-  std::vector<Triplet> as_triplets() const;
+  bool operator==(const CompressedMatrix& other) const {
+    // Rows are built from columns, so it's enough to compare the number of rows.
+    return rows() == other.rows()
+      && col_offsets_ == other.col_offsets_
+      && col_elements_ == other.col_elements_;
+  }
 
 private:
-  const Matrix* matrix_ = nullptr;
-  ViewType view_type_ = {};
+  static Line line(const std::vector<int>& offsets, const std::vector<Element>& elements, int idx) {
+    CHECK(0 <= idx && idx + 1 < offsets.size()) << idx << " not in [0," << offsets.size() - 1 << ")";
+    return Line(elements.data() + offsets[idx], offsets[idx + 1] - offsets[idx]);
+  }
+
+  // Fills rows given columns.
+  void build_rows(int rows);
+
+  // Elements of line `i` are `elements[offsets[i]]` ... `elements[offsets[i+1] - 1]`.
+  std::vector<int> col_offsets_;
+  std::vector<Element> col_elements_;
+  std::vector<int> row_offsets_;
+  std::vector<Element> row_elements_;
 };
 
 
 // Sortes rows in lexicographic order and removes duplicates.
-Matrix sort_unique_rows(const Matrix& matrix);
+CompressedMatrix sort_unique_rows(const CompressedMatrix& matrix);
 
 // Sortes columns in lexicographic order and removes duplicates.
-Matrix sort_unique_cols(const Matrix& matrix);
+CompressedMatrix sort_unique_cols(const CompressedMatrix& matrix);
 
 // Prints matrix elements (with omissions if the matrix is large).
 std::string to_string(const Matrix& matrix);
+std::string to_string(const CompressedMatrix& matrix);
 
 // Prints matrix metadata.
 std::string dump_to_string_impl(const Matrix& matrix);
+std::string dump_to_string_impl(const CompressedMatrix& matrix);
 
 // Saves matrix in the following format:
 //   num_rows num_cols
@@ -100,10 +139,11 @@ std::string dump_to_string_impl(const Matrix& matrix);
 //   row_1 col_1 value_1
 //   row_2 col_2 value_2
 //   ...
-void save_triplets(const std::string& filename, const Matrix& matrix);
+void save_triplets(const std::string& filename, const CompressedMatrix& matrix);
 
-// Loads matrix stored by `save_triplets`.
-Matrix load_triplets(const std::string& filename);
+// Loads matrix stored by `save_triplets`. If an element is listed several times, the last value
+// is used.
+CompressedMatrix load_triplets(const std::string& filename);
 
 // Reads vector written as `[a11, a12, ...; a21, a22, ...; ...]`.
 std::vector<std::vector<int>> load_bracketed_vectors(const std::string& filename);
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+
 #include "absl/container/flat_hash_map.h"
 
 #include "functional.h"
@@ -42,7 +44,7 @@ MemoryUsage simple_container_estimated_ram_usage(const Container& c, bool cap_sp
 }
 
 template<typename T>
-static typename std::enable_if_t<std::is_fundamental_v<T>, MemoryUsage>
+static typename std::enable_if_t<std::is_fundamental_v<T> || std::is_enum_v<T>, MemoryUsage>
 estimated_heap_usage(const T&) {
   return {0, 0};
 }
@@ -79,6 +81,12 @@ MemoryUsage estimated_heap_usage(const std::vector<T>& v) {
   return simple_container_estimated_ram_usage(v, true);
 }
 
+// Counts the pointee in full, as if it was not shared.
+template<typename T>
+MemoryUsage estimated_heap_usage(const std::shared_ptr<T>& p) {
+  return p ? estimated_ram_usage(*p) + MemoryUsage{0, 1} : MemoryUsage{0, 0};
+}
+
 template<typename K, typename V>
 MemoryUsage estimated_heap_usage(const absl::flat_hash_map<K, V>& c) {
   return simple_container_estimated_ram_usage(c, false);
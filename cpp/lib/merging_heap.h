@@ -0,0 +1,58 @@
+// Max-heap of unique keys with associated values. Pushing a key that is already in the heap
+// merges the values (adds them) instead of creating a new entry.
+//
+// The heap itself is a plain binary heap over `std::vector`; values are stored separately in a
+// hash map, so merges don't need to touch the heap. Compared to using an ordered map as a
+// priority queue this avoids per-node allocations and rebalancing.
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+
+#include "check.h"
+
+
+template<typename KeyT, typename ValueT, typename CompareT = std::less<KeyT>>
+class MergingHeap {
+public:
+  explicit MergingHeap(CompareT compare = {}) : compare_(std::move(compare)) {}
+
+  bool empty() const { return keys_.empty(); }
+  int size() const { return keys_.size(); }
+
+  void reserve(int size) {
+    keys_.reserve(size);
+    values_.reserve(size);
+  }
+
+  void push(const KeyT& key, const ValueT& value) {
+    const auto [it, inserted] = values_.try_emplace(key, value);
+    if (inserted) {
+      keys_.push_back(key);
+      std::push_heap(keys_.begin(), keys_.end(), compare_);
+    } else {
+      it->second += value;
+    }
+  }
+
+  // Returns the largest key together with the sum of all values pushed for it.
+  std::pair<KeyT, ValueT> pop() {
+    CHECK(!empty());
+    std::pop_heap(keys_.begin(), keys_.end(), compare_);
+    KeyT key = std::move(keys_.back());
+    keys_.pop_back();
+    const auto it = values_.find(key);
+    ASSERT(it != values_.end());
+    ValueT value = std::move(it->second);
+    values_.erase(it);
+    return {std::move(key), std::move(value)};
+  }
+
+private:
+  CompareT compare_;
+  std::vector<KeyT> keys_;
+  absl::flat_hash_map<KeyT, ValueT> values_;
+};
@@ -0,0 +1,226 @@
+// An always-inline vector of up to 8 one-byte elements packed into a single 64-bit word.
+// Has the same interface as `CappedVector`, but equality, hashing and comparison operate on
+// the whole word instead of element-by-element, and `concat`/`slice` are done with shifts.
+// This makes it a fast hash map key for short words, e.g. `DeltaExpr` monoms.
+//
+// Requirements on `T`: it must be one byte long, `T()` must be all zero bits, and `operator<`
+// must agree with comparing the underlying bytes as unsigned numbers.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <climits>
+#include <compare>
+#include <cstring>
+
+#include "check.h"
+#include "memory_usage_micro.h"
+#include "string.h"
+
+
+template<typename T, uint8_t N>
+class PackedVector {
+public:
+  static_assert(sizeof(T) == 1 && std::has_unique_object_representations_v<T>);
+  static_assert(N <= sizeof(uint64_t));
+  static_assert(std::endian::native == std::endian::little, "Unimplemented: big endian");
+
+  using value_type = T;
+  using size_type = uint8_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using iterator = T*;
+  using const_iterator = const T*;
+
+  static constexpr uint8_t kCapacity = N;
+
+  PackedVector() = default;
+  PackedVector(std::initializer_list<T> init) : PackedVector(init.begin(), init.end()) {}
+  template<class InputIt>
+  PackedVector(InputIt first, InputIt last) {
+    const auto count = std::distance(first, last);
+    CHECK_LE(count, N);
+    std::copy(first, last, data_.begin());
+    size_ = count;
+  }
+
+  static PackedVector from_word(uint64_t word, uint8_t size) {
+    ASSERT(size <= N);
+    ASSERT(size == sizeof(uint64_t) || (word >> (size * CHAR_BIT)) == 0);
+    PackedVector ret;
+    std::memcpy(ret.data_.data(), &word, sizeof(word));
+    ret.size_ = size;
+    return ret;
+  }
+
+  static constexpr bool kCanInline = true;
+
+  // Elements in little-endian order: element `i` occupies bits [8*i, 8*i+8).
+  // Bits past the end are always zero.
+  uint64_t word() const {
+    uint64_t ret;
+    std::memcpy(&ret, data_.data(), sizeof(ret));
+    return ret;
+  }
+
+  uint8_t size() const {
+    return size_;
+  }
+
+  const T& operator[](uint8_t index) const {
+    return data_[index];
+  }
+  T& operator[](uint8_t index) {
+    return data_[index];
+  }
+
+  const T& at(uint8_t index) const {
+    CHECK_LT(index, size_);
+    return data_[index];
+  }
+  T& at(uint8_t index) {
+    CHECK_LT(index, size_);
+    return data_[index];
+  }
+
+  const T& front() const {
+    CHECK(!empty());
+    return data_[0];
+  }
+  T& front() {
+    CHECK(!empty());
+    return data_[0];
+  }
+
+  const T& back() const {
+    CHECK(!empty());
+    return data_[size_ - 1];
+  }
+  T& back() {
+    CHECK(!empty());
+    return data_[size_ - 1];
+  }
+
+  void push_back(const T& value) {
+    CHECK(!full());
+    data_[size_++] = value;
+  }
+
+  void pop_back() {
+    CHECK(!empty());
+    back() = T();
+    --size_;
+  }
+
+  template<class InputIt>
+  void insert(const_iterator pos, InputIt first, InputIt last) {
+    const auto insert_count = std::distance(first, last);
+    CHECK_LE(size_ + insert_count, N);
+    const auto insert_pos = pos - begin();
+    const auto move_count = size_ - insert_pos;
+    if (move_count > 0) {
+      std::move_backward(begin() + insert_pos, end(), end() + insert_count);
+    }
+    std::copy(first, last, begin() + insert_pos);
+    size_ += insert_count;
+  }
+
+  void reserve(uint8_t) {}
+
+  void clear() {
+    data_.fill(T());
+    size_ = 0;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  bool full() const {
+    return size_ == N;
+  }
+
+  const T* data() const {
+    return data_.data();
+  }
+  T* data() {
+    return data_.data();
+  }
+
+  const T* begin() const {
+    return data_.data();
+  }
+  T* begin() {
+    return data_.data();
+  }
+
+  const T* end() const {
+    return data_.data() + size_;
+  }
+  T* end() {
+    return data_.data() + size_;
+  }
+
+  // Lexicographic order. Since unused bytes are zero, comparing byte-swapped words gives
+  // lexicographic order up to the case when one vector is a prefix of the other.
+  std::strong_ordering operator<=>(const PackedVector& other) const {
+    const uint64_t a = std::byteswap(word());
+    const uint64_t b = std::byteswap(other.word());
+    return a != b ? a <=> b : size_ <=> other.size_;
+  }
+  bool operator==(const PackedVector& other) const {
+    return word() == other.word() && size_ == other.size_;
+  }
+
+  // Hashed as a single integer, which absl mixes with one multiplication. Size goes to the top
+  // byte, which is zero unless the vector is full, so there are only collisions between full
+  // vectors and shorter ones.
+  template <typename H>
+  friend H AbslHashValue(H h, const PackedVector& vec) {
+    return H::combine(std::move(h), vec.word() ^ (uint64_t(vec.size_) << 56));
+  }
+
+private:
+  // Always 8 bytes so that `word` is a single load.
+  std::array<T, sizeof(uint64_t)> data_ = {};
+  uint8_t size_ = 0;
+};
+
+static_assert(sizeof(PackedVector<char, 8>) == 9);
+
+template<typename T, uint8_t N>
+PackedVector<T, N> concat(const PackedVector<T, N>& a, const PackedVector<T, N>& b) {
+  CHECK_LE(a.size() + b.size(), N);
+  // Note: shifting by 64 is undefined behaviour; this can only happen if `b` is empty.
+  const uint64_t b_shifted = b.empty() ? 0 : b.word() << (a.size() * CHAR_BIT);
+  return PackedVector<T, N>::from_word(a.word() | b_shifted, a.size() + b.size());
+}
+
+template<typename T, uint8_t N>
+PackedVector<T, N> slice(const PackedVector<T, N>& v, int from, int to = -1) {
+  if (to == -1) {
+    to = v.size();
+  }
+  CHECK(0 <= from && from <= to && to <= v.size())
+      << "Cannot slice vector of length " << int(v.size()) << " from " << from << " to " << to;
+  const int size = to - from;
+  if (size == 0) {
+    return {};
+  }
+  const uint64_t mask = size == sizeof(uint64_t) ? ~uint64_t(0) : (uint64_t(1) << (size * CHAR_BIT)) - 1;
+  return PackedVector<T, N>::from_word((v.word() >> (from * CHAR_BIT)) & mask, size);
+}
+
+template<typename T, uint8_t N>
+std::string dump_to_string_impl(const PackedVector<T, N>& v) {
+  return internal::dump_vector_like_to_string(v);
+}
+
+template<typename T, uint8_t N>
+MemoryUsage estimated_heap_usage(const PackedVector<T, N>&) {
+  return {0, 0};
+}
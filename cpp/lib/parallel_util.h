@@ -1,7 +1,11 @@
 #pragma once
 
+#include <deque>
 #include <execution>
 #include <future>
+#include <mutex>
+#include <optional>
+#include <thread>
 
 #include "util.h"
 
@@ -42,3 +46,77 @@ auto mapped_parallel(const Src& src, const F& func) {
 #else
 #  error Unsupported PARALLELISM_IMPLEMENTATION
 #endif
+
+
+// Returns `num_threads` if it's positive, or hardware concurrency otherwise.
+inline int resolve_num_threads(int num_threads) {
+  return num_threads > 0 ? num_threads : std::max<int>(std::thread::hardware_concurrency(), 1);
+}
+
+// Calls `func(i)` for each `i` in [0, num_tasks) with at most `num_threads` workers and work
+// stealing. Tasks are distributed round-robin between per-worker queues in the given order. Each
+// worker takes tasks from the front of its own queue and, when it is empty, steals from the back
+// of other queues. So if the tasks are sorted from the most expensive to the least expensive,
+// the largest tasks start first and the small ones fill the gaps in the end.
+// Non-positive `num_threads` means hardware concurrency.
+//
+// Workers run via the same parallel algorithms as `mapped_parallel`, i.e. on the shared TBB
+// thread pool rather than on new threads. Thus nested calls (e.g. `matrix_rank` inside
+// `mapped_parallel`) don't oversubscribe the machine: if the pool is busy, some workers simply
+// run later, or not at all once the queues are drained by others.
+template<typename F>
+void parallel_for_work_stealing(int num_tasks, int num_threads, const F& func) {
+  num_threads = std::min(resolve_num_threads(num_threads), num_tasks);
+  if (PARALLELISM_IMPLEMENTATION == 0 || num_threads <= 1) {
+    for (const int i : range(num_tasks)) {
+      func(i);
+    }
+    return;
+  }
+
+  struct TaskQueue {
+    std::mutex mutex;
+    std::deque<int> tasks;
+  };
+  std::vector<TaskQueue> queues(num_threads);
+  for (const int i : range(num_tasks)) {
+    queues[i % num_threads].tasks.push_back(i);
+  }
+  const auto pop_own = [&](int thread_idx) -> std::optional<int> {
+    auto& queue = queues[thread_idx];
+    std::lock_guard lock(queue.mutex);
+    if (queue.tasks.empty()) {
+      return std::nullopt;
+    }
+    const int task = queue.tasks.front();
+    queue.tasks.pop_front();
+    return task;
+  };
+  const auto steal = [&](int thread_idx) -> std::optional<int> {
+    for (const int offset : range(1, num_threads)) {
+      auto& queue = queues[(thread_idx + offset) % num_threads];
+      std::lock_guard lock(queue.mutex);
+      if (!queue.tasks.empty()) {
+        const int task = queue.tasks.back();
+        queue.tasks.pop_back();
+        return task;
+      }
+    }
+    return std::nullopt;
+  };
+
+  const std::vector<int> workers = to_vector(range(num_threads));
+  std::for_each(std::execution::par, workers.begin(), workers.end(), [&](int thread_idx) {
+    while (true) {
+      auto task = pop_own(thread_idx);
+      if (!task.has_value()) {
+        task = steal(thread_idx);
+      }
+      if (!task.has_value()) {
+        // No new tasks can appear, so an empty pool means we are done.
+        break;
+      }
+      func(*task);
+    }
+  });
+}
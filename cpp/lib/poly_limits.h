@@ -8,7 +8,7 @@
 // An expression of weight N is usually a vector of length N. A coexpression
 // with M parts is a vector of M primitive expressions of weight N.
 //
-// Polykit uses three kind of vectors:
+// Polykit uses several kinds of vectors:
 //   * `std::vector`: Regular vector. It uses 24 bytes on a 64-bit system plus
 //     one heap allocation.
 //   * `absl::InlinedVector`: A vector that utilizes inline storage from small
@@ -18,18 +18,31 @@
 //     automatically bumped to avoid wasting space. E.g.
 //     `absl::InlinedVector<uint16_t, 3>` actually stores up to 8 objects inline
 //     because vector size is 24 bytes in either case.
+//   * `SmallVector`: A 16-byte vector of trivially copyable elements that stores
+//     up to 15 bytes inline and spills to heap otherwise. Inline vectors are
+//     compared and hashed as raw bytes.
 //   * `CappedVector`: An always-inline vector that panics when capacity is
 //     exceeded. The size is stored as a single byte, so this vector is much
 //     more memory efficient for small sizes. E.g. `CappedVector<chr, 3>` is
 //     just 4 bytes (c.f. 24 bytes for `absl::InlinedVector`).
+//   * `PackedVector`: A `CappedVector` of up to 8 one-byte elements that is
+//     compared and hashed as a single 64-bit word.
 //
 // Vectors are chosen based on kMaxWeight/kDynamicWeight (similarly for
 // kMaxCoparts/kDynamicCoparts) according to the following logic :
 //   * If kDynamicWeight is true, use `PVector`, which in turn uses:
+//     - `SmallVector` if elements are trivially copyable and kMaxWeight
+//       elements fit into 15 bytes (this is the case for `DeltaExpr`).
 //     - `absl::InlinedVector` if kMaxWeight is a small positive number.
 //     - `std::vector` is kMaxWeight is 0 or large (namely, if
 //       `absl::InlinedVector` object size were to be above `kMaxPVectorSize`)
-//   * If kDynamicWeight is false, use `CappedVector`.
+//   * If kDynamicWeight is false, use `PackedVector` if elements are one byte
+//     long and kMaxWeight <= 8 (this is the case for `DeltaExpr`), and
+//     `CappedVector` otherwise.
+//
+// Coexpression keys (e.g. `DeltaNCoExpr`) are stored as `FlatNestedVector`: all
+// parts in one `PVector` of bytes with a small header. Parts are unpacked into
+// `CopartVector` of part vectors when coexpressions need to be modified.
 
 #pragma once
 
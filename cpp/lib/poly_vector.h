@@ -2,14 +2,36 @@
 
 #include "poly_limits.h"
 #include "capped_vector.h"
+#include "flat_nested_vector.h"
+#include "packed_vector.h"
 #include "pvector.h"
 
 
+namespace internal {
+#if DISABLE_PACKING
+template<typename T, int N>
+constexpr bool can_use_packed_vector = false;
+#else
+template<typename T, int N>
+constexpr bool can_use_packed_vector =
+  sizeof(T) == 1 &&
+  std::has_unique_object_representations_v<T> &&
+  N <= sizeof(uint64_t);
+#endif
+}  // namespace internal
+
+template<typename T, int N>
+using FixedWeightVector = std::conditional_t<
+  internal::can_use_packed_vector<T, N>,
+  PackedVector<T, N>,
+  CappedVector<T, N>
+>;
+
 template<typename T>
 using WeightVector = std::conditional_t<
   kDynamicWeight,
   PVector<T, kMaxWeight>,
-  CappedVector<T, kMaxWeight>
+  FixedWeightVector<T, kMaxWeight>
 >;
 
 template<typename T>
@@ -18,3 +40,8 @@ using CopartVector = std::conditional_t<
   PVector<T, kMaxCoparts>,
   CappedVector<T, kMaxCoparts>
 >;
+
+// All coexpression parts in one buffer. Note that the total weight of a coexpression is
+// the weight of the original expression, so `kMaxWeight` bounds the sum of part sizes.
+template<typename T>
+using FlatCopartVector = FlatNestedVector<T, flat_nested_vector_bytes<T>(kMaxCoparts, kMaxWeight)>;
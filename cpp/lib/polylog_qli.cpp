@@ -1,8 +1,11 @@
 #include "polylog_qli.h"
 
+#include <atomic>
+
 #include "absl/strings/str_cat.h"
 
 #include "algebra.h"
+#include "call_cache.h"
 #include "check.h"
 #include "sequence_iteration.h"
 
@@ -18,8 +21,78 @@ DeltaExpr LogVec(const XArgs& args) {
 struct Point {
   X x = 0;
   bool odd = true;
+
+  auto operator<=>(const Point&) const = default;
+
+  template<typename H>
+  friend H AbslHashValue(H h, const Point& p) {
+    return H::combine(std::move(h), p.x, p.odd);
+  }
 };
 
+// QLi is computed recursively, and the recursion reaches the same foundations via many different
+// paths. So sub-results are memoized by (weight, points), making the computation a DAG evaluation.
+//
+// Without projection, results for different variables are related by a substitution. In this
+// case points are relabeled to canonical variables (in the order of first occurrence) before
+// cache lookup, and the result is substituted back. Thus e.g. all QLi3 with four distinct
+// variables share one cache entry. Such results are kept in a process-wide cache, which also
+// serves repeated top-level calls.
+//
+// Projectors are arbitrary functions that don't commute with substitution. Projected forms use a
+// cache local to the top-level call, keyed by the original points.
+template<typename ResultT>
+using QLiCache = CallCache<ResultT, int, std::vector<Point>>;
+
+// Shared between the "pos" and "neg" caches.
+static constexpr size_t kQLiCacheDefaultMaxBytes = size_t(256) << 20;
+static std::atomic<size_t> qli_cache_max_bytes = kQLiCacheDefaultMaxBytes;
+
+enum class QLiKind { pos, neg };
+
+template<typename ResultT>
+static QLiCache<ResultT>* qli_shared_cache(QLiKind kind) {
+  static QLiCache<ResultT> pos_cache(kQLiCacheDefaultMaxBytes / 2);
+  static QLiCache<ResultT> neg_cache(kQLiCacheDefaultMaxBytes / 2);
+  return kind == QLiKind::pos ? &pos_cache : &neg_cache;
+}
+
+// Returns the process-wide cache if the results can be shared between calls and the cache is
+// enabled, otherwise `local_cache`.
+template<typename ResultT, typename ProjectorT>
+static QLiCache<ResultT>* qli_cache(QLiKind kind, QLiCache<ResultT>* local_cache) {
+  if constexpr (std::is_same_v<ProjectorT, std::identity>) {
+    if (qli_cache_max_bytes.load(std::memory_order_relaxed) > 0) {
+      return qli_shared_cache<ResultT>(kind);
+    }
+  }
+  return local_cache;
+}
+
+// Relabels variables to X::kMinIndex, X::kMinIndex + 1, ... in the order of first occurrence.
+// Fills `substitution` such that `substitute_variables_0_based(expr, substitution)` maps
+// canonical variables back to the original ones. Returns false if some points are not plain
+// variables (constants and negated variables cannot be relabeled).
+static bool canonicalize_points(
+    const std::vector<Point>& points,
+    std::vector<Point>& canonical,
+    std::vector<X>& substitution) {
+  canonical.clear();
+  substitution.assign(X::kMinIndex, X::Undefined());
+  for (const Point& p : points) {
+    if (!p.x.is(XForm::var)) {
+      return false;
+    }
+    const auto it = std::find(substitution.begin() + X::kMinIndex, substitution.end(), p.x);
+    const int idx = it - substitution.begin();
+    if (it == substitution.end()) {
+      substitution.push_back(p.x);
+    }
+    canonical.push_back({X(XForm::var, idx), p.odd});
+  }
+  return true;
+}
+
 // Note: "pos" in "qli_pos_node_func" corresponds to the index in the
 // function name: "QLi+"; "neg" in "neg_cross_ratio" stands for the fact
 // that this is one minus cross ratio. There is no mistake in this mismatch.
@@ -42,7 +115,16 @@ static ResultT QLi_impl(
     int weight,
     const std::vector<Point>& points,
     const QLiNodeT& qli_node_func,
-    const ProjectorT& projector) {
+    const ProjectorT& projector,
+    QLiCache<ResultT>* cache);
+
+template<typename ResultT, typename QLiNodeT, typename ProjectorT>
+static ResultT QLi_impl_uncached(
+    int weight,
+    const std::vector<Point>& points,
+    const QLiNodeT& qli_node_func,
+    const ProjectorT& projector,
+    QLiCache<ResultT>* cache) {
   const int num_points = points.size();
   CHECK(num_points >= 4 && num_points % 2 == 0) << "Bad number of QLi points: " << num_points;
   const int min_weight = (num_points - 2) / 2;
@@ -53,7 +135,7 @@ static ResultT QLi_impl(
       const auto foundation = concat(slice(points, 0, i+1), slice(points, i+3));
       ret += tensor_product(
         projector(qli_node_func(slice(points, i, i+4))),
-        QLi_impl<ResultT>(weight - 1, foundation, qli_node_func, projector)
+        QLi_impl<ResultT>(weight - 1, foundation, qli_node_func, projector, cache)
       );
     }
     return ret;
@@ -67,7 +149,7 @@ static ResultT QLi_impl(
   } else {
     ResultT ret = tensor_product(
       projector(cross_ratio(mapped(points, [](Point p) { return p.x; }))),
-      QLi_impl<ResultT>(weight - 1, points, qli_node_func, projector)
+      QLi_impl<ResultT>(weight - 1, points, qli_node_func, projector, cache)
     );
     if (num_points > 4) {
       ret += subsums();
@@ -76,12 +158,37 @@ static ResultT QLi_impl(
   }
 }
 
+template<typename ResultT, typename QLiNodeT, typename ProjectorT>
+static ResultT QLi_impl(
+    int weight,
+    const std::vector<Point>& points,
+    const QLiNodeT& qli_node_func,
+    const ProjectorT& projector,
+    QLiCache<ResultT>* cache) {
+  if (!cache) {
+    return QLi_impl_uncached<ResultT>(weight, points, qli_node_func, projector, cache);
+  }
+  const auto compute = [&](int w, const std::vector<Point>& p) {
+    return QLi_impl_uncached<ResultT>(w, p, qli_node_func, projector, cache);
+  };
+  if constexpr (std::is_same_v<ProjectorT, std::identity>) {
+    std::vector<Point> canonical;
+    std::vector<X> substitution;
+    if (canonicalize_points(points, canonical, substitution)) {
+      ResultT ret = cache->apply(compute, weight, canonical);
+      return canonical == points ? ret : substitute_variables_0_based(ret, substitution);
+    }
+  }
+  return cache->apply(compute, weight, points);
+}
+
 template<typename ResultT, typename QLiNodeT, typename ProjectorT>
 static ResultT QLi_generic_wrapper(
     int weight,
     const std::vector<X>& points,
     const QLiNodeT& qli_node_func,
-    const ProjectorT& projector) {
+    const ProjectorT& projector,
+    QLiCache<ResultT>* cache) {
   if (points.size() == 2) {
     CHECK_GE(weight, 1);
     return weight == 1 ? projector(D(points[0], points[1])) : ResultT{};
@@ -90,7 +197,7 @@ static ResultT QLi_generic_wrapper(
   for (int i : range(points.size())) {
     tagged_points.push_back({points[i], (i+1) % 2 == 1});
   }
-  return QLi_impl<ResultT>(weight, tagged_points, qli_node_func, projector);
+  return QLi_impl<ResultT>(weight, tagged_points, qli_node_func, projector, cache);
 }
 
 
@@ -99,11 +206,14 @@ static ResultT QLi_wrapper(
     int weight,
     const std::vector<X>& points,
     const ProjectorT& projector) {
-  return QLi_generic_wrapper<ResultT>(weight, points, qli_pos_node_func, projector)
-    .annotate(fmt::function_num_args(
-      fmt::sub_num(fmt::opname("QLi"), {weight}),
-      points
-    ));
+  QLiCache<ResultT> local_cache;
+  return QLi_generic_wrapper<ResultT>(
+    weight, points, qli_pos_node_func, projector,
+    qli_cache<ResultT, ProjectorT>(QLiKind::pos, &local_cache)
+  ).annotate(fmt::function_num_args(
+    fmt::sub_num(fmt::opname("QLi"), {weight}),
+    points
+  ));
 }
 
 DeltaExpr QLiVec(int weight, const XArgs& points) {
@@ -120,9 +230,13 @@ static ResultT QLiNeg_wrapper(
     int weight,
     const std::vector<X>& points,
     const ProjectorT& projector) {
+  QLiCache<ResultT> local_cache;
   return (
       neg_one_pow(weight) *
-      QLi_generic_wrapper<ResultT>(weight, points, qli_neg_node_func, projector)
+      QLi_generic_wrapper<ResultT>(
+        weight, points, qli_neg_node_func, projector,
+        qli_cache<ResultT, ProjectorT>(QLiKind::neg, &local_cache)
+      )
     ).annotate(fmt::function_num_args(
       fmt::sub_num(fmt::super(fmt::opname("QLi"), {"-"}), {weight}),
       points
@@ -140,8 +254,11 @@ ProjectionExpr QLiNegVecPr(int weight, const XArgs& points, DeltaProjector proje
 
 template<typename ResultT, typename ProjectorT>
 static ResultT QLiSymm_wrapper(int weight, const std::vector<X>& points, const ProjectorT& projector) {
+  // Shared by all summands: they have many common sub-foundations.
+  QLiCache<ResultT> local_cache;
+  QLiCache<ResultT>* cache = qli_cache<ResultT, ProjectorT>(QLiKind::pos, &local_cache);
   auto qli_base = [&](const std::vector<X>& args) {
-    return QLi_generic_wrapper<ResultT>(weight, args, qli_pos_node_func, projector);
+    return QLi_generic_wrapper<ResultT>(weight, args, qli_pos_node_func, projector, cache);
   };
   ResultT ret;
   const int num_points = points.size();
@@ -179,6 +296,33 @@ ProjectionExpr QLiSymmVecPr(int weight, const XArgs& points, DeltaProjector proj
   return QLiSymm_wrapper<ProjectionExpr>(weight, points.as_x(), projector);
 }
 
+CallCacheStats QLi_cache_stats() {
+  const auto pos = qli_shared_cache<DeltaExpr>(QLiKind::pos)->stats();
+  const auto neg = qli_shared_cache<DeltaExpr>(QLiKind::neg)->stats();
+  return {
+    .hits = pos.hits + neg.hits,
+    .misses = pos.misses + neg.misses,
+    .evictions = pos.evictions + neg.evictions,
+    .num_entries = pos.num_entries + neg.num_entries,
+    .bytes = pos.bytes + neg.bytes,
+  };
+}
+
+void QLi_clear_cache() {
+  qli_shared_cache<DeltaExpr>(QLiKind::pos)->clear();
+  qli_shared_cache<DeltaExpr>(QLiKind::neg)->clear();
+}
+
+void QLi_set_cache_max_bytes(size_t max_bytes) {
+  qli_cache_max_bytes = max_bytes;
+  if (max_bytes == 0) {
+    QLi_clear_cache();
+  } else {
+    qli_shared_cache<DeltaExpr>(QLiKind::pos)->set_max_bytes(max_bytes / 2);
+    qli_shared_cache<DeltaExpr>(QLiKind::neg)->set_max_bytes(max_bytes / 2);
+  }
+}
+
 
 // A2 symbol definition taken from https://arxiv.org/pdf/1401.6446.pdf, eq. (3.4)
 // except for the coefficient (see below).
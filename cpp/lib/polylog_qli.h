@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include "call_cache.h"
 #include "delta_ratio.h"
 #include "delta.h"
 #include "projection.h"
@@ -38,6 +39,16 @@ ProjectionExpr QLiSymmVecPr(int weight, const XArgs& points, DeltaProjector proj
 
 DeltaExpr A2Vec(const XArgs& args);
 
+// Statistics of the process-wide cache for QLi sub-expressions. Only non-projected forms
+// (`QLiVec`, `QLiNegVec`, `QLiSymmVec` and the corresponding simple forms) use the cache;
+// projected forms are memoized within a single call.
+CallCacheStats QLi_cache_stats();
+// Drops all cached sub-expressions. Useful for benchmarking.
+void QLi_clear_cache();
+// Limits the estimated size of the process-wide cache (256 MiB by default). Zero disables the
+// cache, so that sub-expressions are memoized only within a single call.
+void QLi_set_cache_max_bytes(size_t max_bytes);
+
 // Reduce QLi expr, weight and points must be the same as in QLi.
 // Incompatible with substituting infinity.
 // Can be used as a projector.
@@ -1,12 +1,11 @@
 // Automatic inlined vector. Main difference from absl::InlinedVector is that PVector
 // wouldn't inline if the total object side exceeds certain limit. Optimized for being
-// used as a hash map key.
+// used as a hash map key: short vectors of plain bytes are stored in a 16-byte
+// `SmallVector`.
 
-// Optimization potential: replace absl::InlineVector with a custom implementation
-//   that uses a 1-byte inline size and occupies 16 bytes (rather than 24) on x64.
 // Optimization potential: add uint_4 support in inlined vector.
-// Optimization potential: pack nested inlined vectors in one continuous storage
-//   to allow memcpy/memcmp.
+// Note: nested vectors for coexpressions are packed in one continuous storage by
+//   `FlatNestedVector`.
 // Optimization potential: serialize data (e.g. via ProtocolBuffers or FlatBuffers)
 //   if nesting level is high, but working in key space is unimportant.
 
@@ -23,6 +22,7 @@
 
 #include "check.h"
 #include "memory_usage_micro.h"
+#include "small_vector.h"
 #include "string.h"
 
 
@@ -45,10 +45,23 @@ constexpr int kMaxPVectorSize = 64;
 
 #if DISABLE_PACKING
 template<typename T, int N>
+struct should_use_small_vector {
+  static constexpr bool value = false;
+};
+template<typename T, int N>
 struct should_use_inlined_vector {
   static constexpr bool value = false;
 };
 #else
+// `SmallVector` is preferred when applicable: it's 16 bytes (c.f. 24 bytes for
+// `absl::InlinedVector`) and supports memcmp-based comparison and hashing.
+template<typename T, int N>
+struct should_use_small_vector {
+  static constexpr bool value =
+    std::is_trivially_copyable_v<T> &&
+    std::has_unique_object_representations_v<T> &&
+    0 < N && N * sizeof(T) <= kSmallVectorInlineBytes;
+};
 template<typename T, int N>
 struct should_use_inlined_vector {
   static constexpr bool value = sizeof(absl::InlinedVector<T, N>) < kMaxPVectorSize;
@@ -65,9 +78,13 @@ static_assert(
 
 template<typename T, int N>
 using pvector_base_type = std::conditional_t<
-  should_use_inlined_vector<T, N>::value,
-  absl::InlinedVector<T, N>,
-  std::vector<T>
+  should_use_small_vector<T, N>::value,
+  SmallVector<T>,
+  std::conditional_t<
+    should_use_inlined_vector<T, N>::value,
+    absl::InlinedVector<T, N>,
+    std::vector<T>
+  >
 >;
 }  // namespace internal
 
@@ -90,9 +107,14 @@ std::ostream& operator<<(std::ostream& os, const PVectorStats& stats);
 template<typename T, int N>
 class PVector : public internal::pvector_base_type<T, N> {
 public:
-  static constexpr bool kCanInline = internal::should_use_inlined_vector<T, N>::value;
-  static constexpr size_t kInlineSize = (sizeof(PVector) - sizeof(void*)) / sizeof(T);  // meaningful only if kCanInline is true
+  static constexpr bool kUsesSmallVector = internal::should_use_small_vector<T, N>::value;
+  static constexpr bool kCanInline = kUsesSmallVector || internal::should_use_inlined_vector<T, N>::value;
   using ParentT = internal::pvector_base_type<T, N>;
+  // Meaningful only if kCanInline is true.
+  static constexpr size_t kInlineSize =
+    kUsesSmallVector
+    ? internal::kSmallVectorInlineBytes / sizeof(T)
+    : (sizeof(ParentT) - sizeof(void*)) / sizeof(T);
 
   using ParentT::ParentT;
 
@@ -100,7 +122,9 @@ public:
   std::weak_ordering operator<=>(const PVector&) const = default;
 
   bool is_inlined() const {
-    if constexpr (kCanInline) {
+    if constexpr (kUsesSmallVector) {
+      return ParentT::is_inlined();
+    } else if constexpr (kCanInline) {
       return
         reinterpret_cast<const char*>(this) <= reinterpret_cast<const char*>(this->data()) &&
         reinterpret_cast<const char*>(this->data()) < reinterpret_cast<const char*>(this) + sizeof(PVector)
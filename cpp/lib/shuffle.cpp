@@ -0,0 +1,110 @@
+#include "shuffle.h"
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+
+#include "absl/container/flat_hash_map.h"
+
+
+namespace internal {
+
+// Limits template size to ~1 MB for typical word lengths. Larger products are rare and
+// expensive enough by themselves to make template lookup pointless.
+static constexpr uint64_t kMaxShuffleTemplateRows = 1 << 16;
+static constexpr int kShuffleTemplateKeyBits = 6;
+static constexpr int kMaxShuffleTemplateWords = 64 / kShuffleTemplateKeyBits;
+
+// Packs word lengths into a single integer. Returns nullopt if they don't fit, which can only
+// happen for products that are too large for a template anyway.
+static std::optional<uint64_t> shuffle_template_key(absl::Span<const int> lengths) {
+  if (lengths.size() > kMaxShuffleTemplateWords) {
+    return std::nullopt;
+  }
+  uint64_t key = 0;
+  for (const int n : lengths) {
+    CHECK_GT(n, 0);
+    if (n >= (1 << kShuffleTemplateKeyBits)) {
+      return std::nullopt;
+    }
+    key = (key << kShuffleTemplateKeyBits) | n;
+  }
+  return key;
+}
+
+static bool shuffle_template_fits(absl::Span<const int> lengths) {
+  uint64_t num_rows = 1;
+  int total_length = 0;
+  for (const int n : lengths) {
+    // Multiply by binomial(total_length + n, n) one factor at a time. Partial products
+    // grow monotonically, so it's safe to stop as soon as the limit is exceeded.
+    for (const int i : range_incl(1, n)) {
+      num_rows = num_rows * (total_length + i) / i;
+      if (num_rows > kMaxShuffleTemplateRows) {
+        return false;
+      }
+    }
+    total_length += n;
+  }
+  return true;
+}
+
+static ShuffleTemplate build_shuffle_template(absl::Span<const int> lengths) {
+  using IndexWord = std::vector<uint8_t>;
+  CHECK(!lengths.empty());
+  ShuffleTemplate tmpl;
+  tmpl.word_length = lengths[0];
+  tmpl.num_rows = 1;
+  tmpl.indices = mapped(range(lengths[0]), [](int i) -> uint8_t { return i; });
+  for (const int n : lengths.subspan(1)) {
+    const IndexWord next_word = mapped(
+      range(tmpl.word_length, tmpl.word_length + n),
+      [](int i) -> uint8_t { return i; }
+    );
+    ShuffleTemplate next;
+    next.word_length = tmpl.word_length + n;
+    for (const int i : range(tmpl.num_rows)) {
+      const IndexWord prev_row(tmpl.row(i), tmpl.row(i) + tmpl.word_length);
+      for_each_interleaving(prev_row, next_word, [&](const IndexWord& row) {
+        next.indices.insert(next.indices.end(), row.begin(), row.end());
+        ++next.num_rows;
+      });
+    }
+    tmpl = std::move(next);
+  }
+  return tmpl;
+}
+
+const ShuffleTemplate* get_shuffle_template(absl::Span<const int> lengths) {
+  const auto key = shuffle_template_key(lengths);
+  if (!key.has_value()) {
+    return nullptr;
+  }
+  // Thread-local view of the global cache: the common case doesn't touch shared state.
+  thread_local absl::flat_hash_map<uint64_t, const ShuffleTemplate*> local_cache;
+  if (const auto it = local_cache.find(*key); it != local_cache.end()) {
+    return it->second;
+  }
+
+  static std::shared_mutex mutex;
+  static absl::flat_hash_map<uint64_t, std::unique_ptr<const ShuffleTemplate>> global_cache;
+  const ShuffleTemplate* ret = nullptr;
+  {
+    std::shared_lock lock(mutex);
+    if (const auto it = global_cache.find(*key); it != global_cache.end()) {
+      ret = it->second.get();
+    }
+  }
+  if (!ret && shuffle_template_fits(lengths)) {
+    // Build outside of the lock. If another thread has built the same template meanwhile, ours
+    // is discarded.
+    auto tmpl = std::make_unique<const ShuffleTemplate>(build_shuffle_template(lengths));
+    std::unique_lock lock(mutex);
+    ret = global_cache.try_emplace(*key, std::move(tmpl)).first->second.get();
+  }
+  local_cache[*key] = ret;
+  return ret;
+}
+
+}  // namespace internal
@@ -10,17 +10,96 @@
 
 #pragma once
 
+#include <cstdint>
 #include <vector>
 
+#include "absl/algorithm/container.h"
+#include "absl/types/span.h"
+
 #include "algebra.h"
 #include "util.h"
-#include "shuffle_unrolled.h"
-#include "shuffle_unrolled_multi.h"
 
 
-template<typename MonomT>
-BasicLinear<SimpleLinearParam<MonomT>> shuffle_product(const MonomT& u, const MonomT& v) {
-  using LinearT = BasicLinear<SimpleLinearParam<MonomT>>;
+namespace internal {
+// Returns binomial(n + m, n).
+inline uint64_t num_interleavings(int n, int m) {
+  uint64_t ret = 1;
+  for (const int i : range_incl(1, n)) {
+    ret = ret * (m + i) / i;
+  }
+  return ret;
+}
+
+// Calls `func(word)` for each of the binomial(n + m, n) interleavings of `u` and `v`, where n and
+// m are the word lengths. Equal words are reported separately if they come from different
+// interleavings. Each interleaving corresponds to a bit mask with n set bits marking the positions
+// taken by `u`. The masks are enumerated in increasing order via Gosper's hack, so there is no
+// recursion and the same word buffer is reused for all interleavings.
+template<typename MonomT, typename F>
+void for_each_interleaving(const MonomT& u, const MonomT& v, const F& func) {
+  const int n = u.size();
+  const int m = v.size();
+  const int len = n + m;
+  CHECK_LT(len, 64) << "Words are too long to shuffle";
+  MonomT word = u;
+  word.insert(word.end(), v.begin(), v.end());
+  const uint64_t first_mask = (uint64_t(1) << n) - 1;
+  const uint64_t last_mask = first_mask << m;
+  uint64_t mask = first_mask;
+  while (true) {
+    int idx_u = 0;
+    int idx_v = 0;
+    for (const int pos : range(len)) {
+      word[pos] = (mask >> pos) & 1 ? u[idx_u++] : v[idx_v++];
+    }
+    func(std::as_const(word));
+    if (mask == last_mask) {
+      break;
+    }
+    const uint64_t lowest_bit = mask & -mask;
+    const uint64_t ripple = mask + lowest_bit;
+    mask = (((ripple ^ mask) >> 2) / lowest_bit) | ripple;
+  }
+}
+
+// Shuffle template for words of lengths (n_1, ..., n_k): all multinomial(n_1, ..., n_k)
+// interleavings stored as a table of indices. Row i, position j holds the index of the letter
+// that goes to position j of the i-th interleaving, counted in the concatenation w_1 w_2 ... w_k.
+// Thus a shuffle product is a gather from the concatenated input, which does not depend on
+// either the letter type or the word contents.
+struct ShuffleTemplate {
+  int word_length = 0;
+  int num_rows = 0;
+  std::vector<uint8_t> indices;  // num_rows * word_length
+
+  const uint8_t* row(int i) const { return indices.data() + i * word_length; }
+};
+
+// Templates are built lazily and cached, which is thread-safe. Word lengths must be positive.
+// Returns nullptr if the template would be too large, in which case the caller should fall
+// back to `for_each_interleaving`.
+const ShuffleTemplate* get_shuffle_template(absl::Span<const int> lengths);
+
+template<typename LinearT, typename MonomT>
+LinearT apply_shuffle_template(const ShuffleTemplate& tmpl, const MonomT& letters) {
+  const int len = tmpl.word_length;
+  CHECK_EQ(int(letters.size()), len);
+  typename LinearT::ContainerT terms;
+  terms.reserve(tmpl.num_rows);
+  MonomT word = letters;
+  for (const int i : range(tmpl.num_rows)) {
+    const uint8_t* row = tmpl.row(i);
+    for (const int pos : range(len)) {
+      word[pos] = letters[row[pos]];
+    }
+    auto& coeff = terms[word];
+    coeff = coeff_add(coeff, typename LinearT::CoeffT(1));
+  }
+  return LinearT(std::move(terms));
+}
+
+template<typename LinearT, typename MonomT>
+LinearT shuffle_product_impl(const MonomT& u, const MonomT& v) {
   if (u.empty() && v.empty()) {
     return {};
   }
@@ -30,60 +109,81 @@ BasicLinear<SimpleLinearParam<MonomT>> shuffle_product(const MonomT& u, const Mo
   if (v.empty()) {
     return LinearT::single_key(u);
   }
-#if UNROLL_SHUFFLE
-  {
-    auto unrolled_ret = shuffle_product_unrolled(u, v);
-    if (!unrolled_ret.is_zero()) {
-      return unrolled_ret;
-    }
+  const int n = u.size();
+  const int m = v.size();
+  if (n > m) {
+    // Shuffle is commutative: swap words in order to halve the number of templates.
+    return shuffle_product_impl<LinearT>(v, u);
   }
-#endif
-  const auto a = u.back();
-  const auto b = v.back();
-  MonomT u_trunc = u;
-  MonomT v_trunc = v;
-  u_trunc.pop_back();
-  v_trunc.pop_back();
-  LinearT ret;
-  shuffle_product(u, v_trunc).foreach_key([&](MonomT w, int coeff) {
-    w.push_back(b);
-    ret.add_to_key(w, coeff);
-  });
-  shuffle_product(u_trunc, v).foreach_key([&](MonomT w, int coeff) {
-    w.push_back(a);
-    ret.add_to_key(w, coeff);
+  if (const ShuffleTemplate* tmpl = get_shuffle_template({n, m})) {
+    MonomT letters = u;
+    letters.insert(letters.end(), v.begin(), v.end());
+    return apply_shuffle_template<LinearT>(*tmpl, letters);
+  }
+  typename LinearT::ContainerT terms;
+  terms.reserve(num_interleavings(n, m));
+  for_each_interleaving(u, v, [&](const MonomT& word) {
+    auto& coeff = terms[word];
+    coeff = coeff_add(coeff, typename LinearT::CoeffT(1));
   });
-  return ret;
+  return LinearT(std::move(terms));
 }
 
-// Returns  w1 ⧢ w2 ⧢ ... ⧢ wn
-template<typename MonomT>
-BasicLinear<SimpleLinearParam<MonomT>> shuffle_product(std::vector<MonomT> words) {
-  // Optimization potential: unroll for 3-4 words.
-  using LinearT = BasicLinear<SimpleLinearParam<MonomT>>;
+template<typename LinearT, typename MonomT>
+LinearT shuffle_product_impl(std::vector<MonomT> words) {
+  // Empty words are neutral elements, so they can be dropped unless there is nothing else.
+  // For all-empty input keep the result of the pairwise product.
+  if (absl::c_any_of(words, [](const MonomT& w) { return !w.empty(); })) {
+    std::erase_if(words, [](const MonomT& w) { return w.empty(); });
+  } else if (words.size() > 2) {
+    return {};
+  }
   if (words.size() == 0) {
     return {};
   } else if (words.size() == 1) {
     return LinearT::single_key(words[0]);
   } else if (words.size() == 2) {
-    return shuffle_product(words[0], words[1]);
-  } else {
-#if UNROLL_SHUFFLE_MULTI
-      {
-        // May change `words` order, but that's ok: shuffle is commutative.
-        auto unrolled_ret = shuffle_product_unrolled_multi(words);
-        if (!unrolled_ret.is_zero()) {
-          return unrolled_ret;
-        }
-      }
-#endif
-    MonomT w_tail = words.back();
-    words.pop_back();
-    const LinearT shuffle_product_head = shuffle_product(words);
-    return shuffle_product_head.mapped_key_expanding([&](MonomT w_head) {
-      return shuffle_product(w_head, w_tail);
+    return shuffle_product_impl<LinearT>(words[0], words[1]);
+  }
+  // Similarly to the two-word case, order words by length in order to share templates.
+  absl::c_stable_sort(words, [](const MonomT& a, const MonomT& b) { return a.size() < b.size(); });
+  const std::vector<int> lengths = mapped(words, [](const MonomT& w) { return int(w.size()); });
+  if (const ShuffleTemplate* tmpl = get_shuffle_template(lengths)) {
+    MonomT letters;
+    for (const MonomT& w : words) {
+      letters.insert(letters.end(), w.begin(), w.end());
+    }
+    return apply_shuffle_template<LinearT>(*tmpl, letters);
+  }
+  // The product is too large for a template. Go pairwise, keeping the intermediate result in
+  // an arena. Note that `acc` must be constructed outside the arena scope.
+  MonomT w_tail = std::move(words.back());
+  words.pop_back();
+  typename LinearT::Accumulator acc;
+  {
+    ScopedArena arena;
+    // Intermediate results are short-lived, so they are allocated in an arena in order to
+    // reduce the pressure on the global allocator.
+    using ArenaLinearT = ArenaBasicLinear<typename LinearT::Param>;
+    const auto shuffle_product_head = shuffle_product_impl<ArenaLinearT>(words);
+    shuffle_product_head.foreach_key([&](const MonomT& w_head, const auto& coeff) {
+      acc.add_expr(shuffle_product_impl<LinearT>(w_head, w_tail), coeff);
     });
   }
+  return acc.materialize();
+}
+}  // namespace internal
+
+
+template<typename MonomT>
+BasicLinear<SimpleLinearParam<MonomT>> shuffle_product(const MonomT& u, const MonomT& v) {
+  return internal::shuffle_product_impl<BasicLinear<SimpleLinearParam<MonomT>>>(u, v);
+}
+
+// Returns  w1 ⧢ w2 ⧢ ... ⧢ wn
+template<typename MonomT>
+BasicLinear<SimpleLinearParam<MonomT>> shuffle_product(std::vector<MonomT> words) {
+  return internal::shuffle_product_impl<BasicLinear<SimpleLinearParam<MonomT>>>(std::move(words));
 }
 
 
@@ -0,0 +1,362 @@
+// A 16-byte vector of trivially copyable elements optimized for being used as a hash map key.
+// Stores up to `kInlineCapacity` elements (15 bytes) inline, spills to heap otherwise.
+//
+// Layout: the last byte is a tag which is either the inline size or `kHeapTag`. In inline
+// mode the first 15 bytes hold the elements, and unused bytes are always zero, so two inline
+// vectors are equal iff their 16-byte representations are equal. In heap mode the first 8
+// bytes are the data pointer, the next 4 bytes are the size, and the next byte is log2 of the
+// capacity.
+//
+// Requirements on `T`: it must be trivially copyable and have unique object representations,
+// so that equality can be checked with `memcmp` and hashing can operate on raw bytes.
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <compare>
+#include <cstring>
+#include <iterator>
+
+#include "check.h"
+#include "memory_usage_micro.h"
+#include "string.h"
+
+
+namespace internal {
+constexpr size_t kSmallVectorInlineBytes = 15;
+}  // namespace internal
+
+template<typename T>
+class SmallVector {
+public:
+  static_assert(std::is_trivially_copyable_v<T> && std::has_unique_object_representations_v<T>);
+  static_assert(sizeof(T) <= internal::kSmallVectorInlineBytes);
+
+  using value_type = T;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using iterator = T*;
+  using const_iterator = const T*;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  static constexpr size_t kInlineCapacity = internal::kSmallVectorInlineBytes / sizeof(T);
+
+  SmallVector() = default;
+  explicit SmallVector(size_t count) : SmallVector(count, T()) {}
+  SmallVector(size_t count, const T& value) {
+    resize(count, value);
+  }
+  SmallVector(std::initializer_list<T> init) : SmallVector(init.begin(), init.end()) {}
+  template<typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+  SmallVector(InputIt first, InputIt last) {
+    insert(end(), first, last);
+  }
+
+  SmallVector(const SmallVector& other) {
+    if (other.is_inlined()) {
+      std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+    } else {
+      reserve(other.size());
+      copy_elements(other.data(), other.size(), data());
+      set_size(other.size());
+    }
+  }
+  SmallVector(SmallVector&& other) noexcept {
+    std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+    other.reset_to_empty_inline();
+  }
+  SmallVector& operator=(const SmallVector& other) {
+    if (this != &other) {
+      clear();
+      insert(end(), other.begin(), other.end());
+    }
+    return *this;
+  }
+  SmallVector& operator=(SmallVector&& other) noexcept {
+    if (this != &other) {
+      free_heap();
+      std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+      other.reset_to_empty_inline();
+    }
+    return *this;
+  }
+  ~SmallVector() {
+    free_heap();
+  }
+
+  bool is_inlined() const { return tag() != kHeapTag; }
+
+  size_t size() const { return is_inlined() ? tag() : heap_size(); }
+  bool empty() const { return size() == 0; }
+  size_t capacity() const { return is_inlined() ? kInlineCapacity : size_t(1) << heap_capacity_log2(); }
+
+  const T* data() const { return is_inlined() ? reinterpret_cast<const T*>(bytes_) : heap_data(); }
+  T* data() { return is_inlined() ? reinterpret_cast<T*>(bytes_) : heap_data(); }
+
+  const_iterator begin() const { return data(); }
+  iterator begin() { return data(); }
+  const_iterator end() const { return data() + size(); }
+  iterator end() { return data() + size(); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+  const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+
+  const T& operator[](size_t index) const { return data()[index]; }
+  T& operator[](size_t index) { return data()[index]; }
+
+  const T& at(size_t index) const {
+    CHECK_LT(index, size());
+    return data()[index];
+  }
+  T& at(size_t index) {
+    CHECK_LT(index, size());
+    return data()[index];
+  }
+
+  const T& front() const {
+    CHECK(!empty());
+    return data()[0];
+  }
+  T& front() {
+    CHECK(!empty());
+    return data()[0];
+  }
+
+  const T& back() const {
+    CHECK(!empty());
+    return data()[size() - 1];
+  }
+  T& back() {
+    CHECK(!empty());
+    return data()[size() - 1];
+  }
+
+  void reserve(size_t new_capacity) {
+    if (new_capacity <= capacity()) {
+      return;
+    }
+    const int capacity_log2 = std::bit_width(new_capacity - 1);
+    CHECK_LT(capacity_log2, 32);
+    const size_t old_size = size();
+    T* new_data = static_cast<T*>(::operator new(sizeof(T) << capacity_log2));
+    copy_elements(data(), old_size, new_data);
+    free_heap();
+    set_heap(new_data, old_size, capacity_log2);
+  }
+
+  void resize(size_t new_size, const T& value = T()) {
+    const size_t old_size = size();
+    if (new_size > old_size) {
+      reserve(new_size);
+      std::fill(data() + old_size, data() + new_size, value);
+      set_size(new_size);
+    } else {
+      truncate(new_size);
+    }
+  }
+
+  void clear() {
+    truncate(0);
+  }
+
+  void push_back(const T& value) {
+    const T copy = value;  // `value` could point inside the vector
+    reserve_for_growth(size() + 1);
+    data()[size()] = copy;
+    set_size(size() + 1);
+  }
+  template<typename... Args>
+  T& emplace_back(Args&&... args) {
+    push_back(T(std::forward<Args>(args)...));
+    return back();
+  }
+
+  void pop_back() {
+    CHECK(!empty());
+    truncate(size() - 1);
+  }
+
+  iterator insert(const_iterator pos, const T& value) {
+    return insert(pos, &value, &value + 1);
+  }
+  iterator insert(const_iterator pos, std::initializer_list<T> init) {
+    return insert(pos, init.begin(), init.end());
+  }
+  template<typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+  iterator insert(const_iterator pos, InputIt first, InputIt last) {
+    const size_t insert_pos = pos - begin();
+    const size_t old_size = size();
+    CHECK_LE(insert_pos, old_size);
+    if constexpr (std::contiguous_iterator<InputIt> && std::is_same_v<std::iter_value_t<InputIt>, T>) {
+      const size_t count = std::distance(first, last);
+      // The source range could point inside the vector, which is about to be modified.
+      const bool aliased = count > 0 && begin() <= std::to_address(first) && std::to_address(first) < end();
+      if (aliased) {
+        const SmallVector tmp(first, last);
+        return insert(pos, tmp.begin(), tmp.end());
+      }
+      reserve_for_growth(old_size + count);
+      T* d = data();
+      std::memmove(d + insert_pos + count, d + insert_pos, (old_size - insert_pos) * sizeof(T));
+      copy_elements(std::to_address(first), count, d + insert_pos);
+      set_size(old_size + count);
+    } else {
+      for (; first != last; ++first) {
+        push_back(*first);
+      }
+      std::rotate(begin() + insert_pos, begin() + old_size, end());
+    }
+    return begin() + insert_pos;
+  }
+
+  iterator erase(const_iterator pos) {
+    return erase(pos, pos + 1);
+  }
+  iterator erase(const_iterator first, const_iterator last) {
+    const size_t from = first - begin();
+    const size_t to = last - begin();
+    const size_t old_size = size();
+    CHECK(from <= to && to <= old_size);
+    T* d = data();
+    std::memmove(d + from, d + to, (old_size - to) * sizeof(T));
+    truncate(old_size - (to - from));
+    return begin() + from;
+  }
+
+  void swap(SmallVector& other) noexcept {
+    std::swap(bytes_, other.bytes_);
+  }
+
+  bool operator==(const SmallVector& other) const {
+    if (is_inlined() && other.is_inlined()) {
+      return std::memcmp(bytes_, other.bytes_, sizeof(bytes_)) == 0;
+    }
+    return size() == other.size() && std::memcmp(data(), other.data(), size() * sizeof(T)) == 0;
+  }
+  std::weak_ordering operator<=>(const SmallVector& other) const {
+    return std::lexicographical_compare_three_way(
+      begin(), end(), other.begin(), other.end(), std::compare_weak_order_fallback
+    );
+  }
+
+  // Short vectors are hashed as two 64-bit words regardless of whether they are on heap, so
+  // that equal vectors always have equal hashes.
+  template <typename H>
+  friend H AbslHashValue(H h, const SmallVector& vec) {
+    if (vec.size() <= kInlineCapacity) {
+      uint64_t words[2];
+      if (vec.is_inlined()) {
+        std::memcpy(words, vec.bytes_, sizeof(words));
+      } else {
+        SmallVector inlined;
+        inlined.set_size(vec.size());
+        copy_elements(vec.data(), vec.size(), inlined.data());
+        std::memcpy(words, inlined.bytes_, sizeof(words));
+      }
+      return H::combine(std::move(h), words[0], words[1]);
+    }
+    return H::combine(
+      H::combine_contiguous(std::move(h), reinterpret_cast<const unsigned char*>(vec.data()), vec.size() * sizeof(T)),
+      vec.size()
+    );
+  }
+
+private:
+  static constexpr uint8_t kHeapTag = 0xff;
+  static constexpr size_t kTagOffset = internal::kSmallVectorInlineBytes;
+  static constexpr size_t kHeapSizeOffset = sizeof(T*);
+  static constexpr size_t kHeapCapacityOffset = kHeapSizeOffset + sizeof(uint32_t);
+
+  static void copy_elements(const T* src, size_t count, T* dst) {
+    if (count > 0) {
+      std::memcpy(dst, src, count * sizeof(T));
+    }
+  }
+
+  uint8_t tag() const { return static_cast<uint8_t>(bytes_[kTagOffset]); }
+  void set_tag(uint8_t tag) { bytes_[kTagOffset] = static_cast<unsigned char>(tag); }
+
+  T* heap_data() const {
+    T* ret;
+    std::memcpy(&ret, bytes_, sizeof(ret));
+    return ret;
+  }
+  uint32_t heap_size() const {
+    uint32_t ret;
+    std::memcpy(&ret, bytes_ + kHeapSizeOffset, sizeof(ret));
+    return ret;
+  }
+  uint8_t heap_capacity_log2() const {
+    return static_cast<uint8_t>(bytes_[kHeapCapacityOffset]);
+  }
+
+  void set_heap(T* heap_data, uint32_t size, uint8_t capacity_log2) {
+    std::memcpy(bytes_, &heap_data, sizeof(heap_data));
+    std::memcpy(bytes_ + kHeapSizeOffset, &size, sizeof(size));
+    bytes_[kHeapCapacityOffset] = static_cast<unsigned char>(capacity_log2);
+    set_tag(kHeapTag);
+  }
+
+  // Requires `new_size <= capacity()`. Shrinking an inline vector zeroes the tail.
+  void set_size(size_t new_size) {
+    if (is_inlined()) {
+      ASSERT(new_size <= kInlineCapacity);
+      set_tag(new_size);
+    } else {
+      const uint32_t size = new_size;
+      std::memcpy(bytes_ + kHeapSizeOffset, &size, sizeof(size));
+    }
+  }
+
+  void truncate(size_t new_size) {
+    const size_t old_size = size();
+    CHECK_LE(new_size, old_size);
+    if (is_inlined()) {
+      std::memset(bytes_ + new_size * sizeof(T), 0, (old_size - new_size) * sizeof(T));
+    }
+    set_size(new_size);
+  }
+
+  void reserve_for_growth(size_t new_size) {
+    if (new_size > capacity()) {
+      reserve(std::max(new_size, capacity() * 2));
+    }
+  }
+
+  void free_heap() {
+    if (!is_inlined()) {
+      ::operator delete(heap_data());
+    }
+  }
+
+  void reset_to_empty_inline() {
+    std::memset(bytes_, 0, sizeof(bytes_));
+  }
+
+  alignas(T*) unsigned char bytes_[internal::kSmallVectorInlineBytes + 1] = {};
+};
+
+static_assert(sizeof(SmallVector<char>) == 16);
+
+template<typename T>
+std::string dump_to_string_impl(const SmallVector<T>& v) {
+  return internal::dump_vector_like_to_string(v);
+}
+
+template<typename T>
+MemoryUsage estimated_heap_usage(const SmallVector<T>& v) {
+  if (v.is_inlined()) {
+    return {0, 0};
+  } else {
+    return simple_container_estimated_ram_usage(v, true);
+  }
+}
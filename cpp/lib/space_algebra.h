@@ -1,6 +1,9 @@
 #pragma once
 
+#include <variant>
+
 #include "expr_matrix_builder.h"
+#include "incremental_rank.h"
 #include "linalg.h"
 #include "parallel_util.h"
 #include "profiler.h"
@@ -41,63 +44,156 @@ std::string to_string(const SpaceVennRanks& ranks);
 std::string to_string(const SpaceMappingRanks& ranks);
 
 
-template<typename SpaceT, typename PrepareF, typename MatrixBuilderT>
-void add_space_to_matrix_builder(const SpaceT& space, const PrepareF& prepare, MatrixBuilderT& matrix_builder) {
+// Computes rank of a space that grows one expression at a time. See `IncrementalRankBuilder`.
+template<typename ExprT>
+class SpaceRankBuilder {
+public:
+  explicit SpaceRankBuilder(RankBackend backend, bool track_combinations = false)
+    : rank_builder_(backend, track_combinations) {}
+
+  int rank() const { return rank_builder_.rank(); }
+
+  // Returns true iff the rank increased.
+  bool add_expr(const ExprT& expr) {
+    return rank_builder_.add_col(matrix_builder_.make_col(expr));
+  }
+  bool contains(const ExprT& expr) {
+    return rank_builder_.contains(matrix_builder_.make_col(expr));
+  }
+  // Returns indices of the expressions required to express `expr`. See `IncrementalRankBuilder::decompose`.
+  std::optional<std::vector<int>> decompose(const ExprT& expr) {
+    return rank_builder_.decompose(matrix_builder_.make_col(expr));
+  }
+
+private:
+  GetExprMatrixBuilder_t<ExprT> matrix_builder_;  // used only to assign monoms to rows
+  IncrementalRankBuilder rank_builder_;
+};
+
+// Computes rank of a space that grows in batches. With `RankBackend::modular` the rank is updated
+// incrementally. With `RankBackend::exact` the whole matrix is passed to `matrix_rank` each time:
+// fraction-free elimination in `IncrementalRankBuilder` is prone to coefficient growth, and rank
+// modulo a prime is only a lower bound, so it would have to be verified by a full exact rank
+// computation anyway.
+template<typename ExprT>
+class SpaceBatchRank {
+public:
+  explicit SpaceBatchRank(RankBackend backend) {
+    if (backend == RankBackend::modular) {
+      impl_.template emplace<SpaceRankBuilder<ExprT>>(backend);
+    }
+  }
+
+  void add_exprs(const std::vector<ExprT>& exprs) {
+    std::visit([&](auto& impl) {
+      for (const auto& expr : exprs) {
+        impl.add_expr(expr);
+      }
+    }, impl_);
+  }
+
+  int rank() const {
+    return std::visit(overloaded{
+      [](const GetExprMatrixBuilder_t<ExprT>& matrix_builder) {
+        return matrix_rank(matrix_builder.make_matrix(), RankBackend::exact);
+      },
+      [](const SpaceRankBuilder<ExprT>& rank_builder) {
+        return rank_builder.rank();
+      },
+    }, impl_);
+  }
+
+private:
+  std::variant<GetExprMatrixBuilder_t<ExprT>, SpaceRankBuilder<ExprT>> impl_;
+};
+
+
+template<typename SpaceT, typename PrepareF>
+auto prepare_space(const SpaceT& space, const PrepareF& prepare) {
   check_spaces(space);
-  const auto space_prepared = mapped_parallel(space, [prepare](const auto& s) {
+  return mapped_parallel(space, [prepare](const auto& s) {
     return prepare(s);
   });
-  for (const auto& expr : space_prepared) {
-    matrix_builder.add_expr(expr);
-  }
 }
 
+// Expressions are prepared and converted to columns in one parallel pass, so prepared
+// expressions are never stored all at once.
 template<typename SpaceT, typename PrepareF>
-Matrix space_matrix(const SpaceT& space, const PrepareF& prepare) {
+CompressedMatrix space_matrix(const SpaceT& space, const PrepareF& prepare) {
   using ExprT = std::decay_t<std::invoke_result_t<PrepareF, typename SpaceT::value_type>>;
-  GetExprMatrixBuilder_t<ExprT> matrix_builder;
-  add_space_to_matrix_builder(space, prepare, matrix_builder);
-  return matrix_builder.make_matrix();
+  check_spaces(space);
+  ConcurrentExprMatrixBuilder<ExprT> matrix_builder;
+  matrix_builder.add_exprs(space, prepare);
+  return std::move(matrix_builder).make_matrix();
+}
+
+template<typename SpaceT, typename PrepareF>
+int space_rank(const SpaceT& space, const PrepareF& prepare, RankBackend backend = RankBackend::exact) {
+  return matrix_rank(space_matrix(space, prepare), backend);
 }
 
+// Like `space_rank`, but the matrix is kept in file `filename` rather than in memory, see
+// `spilled_matrix.h`. Use this for spaces that don't fit into RAM.
 template<typename SpaceT, typename PrepareF>
-int space_rank(const SpaceT& space, const PrepareF& prepare) {
-  return matrix_rank(space_matrix(space, prepare));
+int space_rank_out_of_core(
+  const SpaceT& space, const PrepareF& prepare, const std::string& filename,
+  RankBackend backend = RankBackend::exact
+) {
+  using ExprT = std::decay_t<std::invoke_result_t<PrepareF, typename SpaceT::value_type>>;
+  // Prepared expressions are only stored for one batch at a time.
+  const int kBatchSize = 1 << 12;
+  check_spaces(space);
+  SpillingExprMatrixBuilder<ExprT> matrix_builder(filename);
+  for (int begin = 0; begin < space.size(); begin += kBatchSize) {
+    const int end = std::min<int>(begin + kBatchSize, space.size());
+    const std::vector batch(space.begin() + begin, space.begin() + end);
+    for (const auto& expr : mapped_parallel(batch, prepare)) {
+      matrix_builder.add_expr(expr);
+    }
+  }
+  return matrix_rank_out_of_core(matrix_builder.finish(), backend);
 }
 
 template<typename SpaceT, typename PrepareF>
-bool space_contains(const SpaceT& haystack, const SpaceT& needle, const PrepareF& prepare) {
+bool space_contains(
+  const SpaceT& haystack, const SpaceT& needle, const PrepareF& prepare,
+  RankBackend backend = RankBackend::exact
+) {
   check_spaces(haystack, needle);
   using ExprT = std::decay_t<std::invoke_result_t<PrepareF, typename SpaceT::value_type>>;
-  GetExprMatrixBuilder_t<ExprT> matrix_builder;
-  add_space_to_matrix_builder(haystack, prepare, matrix_builder);
-  const int haystack_rank = matrix_rank(matrix_builder.make_matrix());
-  add_space_to_matrix_builder(needle, prepare, matrix_builder);
-  const int united_rank = matrix_rank(matrix_builder.make_matrix());
+  SpaceBatchRank<ExprT> rank(backend);
+  rank.add_exprs(prepare_space(haystack, prepare));
+  const int haystack_rank = rank.rank();
+  rank.add_exprs(prepare_space(needle, prepare));
+  const int united_rank = rank.rank();
   CHECK_LE(haystack_rank, united_rank);
   return united_rank == haystack_rank;
 }
 
 template<typename SpaceT, typename PrepareF>
-SpaceVennRanks space_venn_ranks(const SpaceT& a, const SpaceT& b, const PrepareF& prepare) {
+SpaceVennRanks space_venn_ranks(
+  const SpaceT& a, const SpaceT& b, const PrepareF& prepare,
+  RankBackend backend = RankBackend::exact
+) {
   check_spaces(a, b);
   using ExprT = std::decay_t<std::invoke_result_t<PrepareF, typename SpaceT::value_type>>;
   Profiler profiler(false);
 
-  GetExprMatrixBuilder_t<ExprT> matrix_builder_a;
-  add_space_to_matrix_builder(a, prepare, matrix_builder_a);
-  profiler.finish("A space");
-  const int a_rank = matrix_rank(matrix_builder_a.make_matrix());
+  const auto a_prepared = prepare_space(a, prepare);
+  const auto b_prepared = prepare_space(b, prepare);
+  profiler.finish("prepare spaces");
+
+  SpaceBatchRank<ExprT> united_rank_builder(backend);
+  united_rank_builder.add_exprs(a_prepared);
+  const int a_rank = united_rank_builder.rank();
   profiler.finish("A rank");
-  add_space_to_matrix_builder(b, prepare, matrix_builder_a);
-  profiler.finish("united space");
-  const int united_rank = matrix_rank(matrix_builder_a.make_matrix());
+  united_rank_builder.add_exprs(b_prepared);
+  const int united_rank = united_rank_builder.rank();
   profiler.finish("united rank");
 
-  GetExprMatrixBuilder_t<ExprT> matrix_builder_b;
-  add_space_to_matrix_builder(b, prepare, matrix_builder_b);
-  profiler.finish("B space");
-  const int b_rank = matrix_rank(matrix_builder_b.make_matrix());
+  SpaceBatchRank<ExprT> b_rank_builder(backend);
+  b_rank_builder.add_exprs(b_prepared);
+  const int b_rank = b_rank_builder.rank();
   profiler.finish("B rank");
 
   CHECK_LE(a_rank, united_rank);
@@ -106,20 +202,26 @@ SpaceVennRanks space_venn_ranks(const SpaceT& a, const SpaceT& b, const PrepareF
 }
 
 template<typename SpaceT, typename PrepareF>
-bool space_equal(const SpaceT& a, const SpaceT& b, const PrepareF& prepare) {
-  return space_venn_ranks(a, b, prepare).are_equal();
+bool space_equal(
+  const SpaceT& a, const SpaceT& b, const PrepareF& prepare,
+  RankBackend backend = RankBackend::exact
+) {
+  return space_venn_ranks(a, b, prepare, backend).are_equal();
 }
 
 template<typename SpaceT, typename PrepareF, typename MapF>
-SpaceMappingRanks space_mapping_ranks(const SpaceT& raw_space, const PrepareF& prepare, const MapF& map) {
+SpaceMappingRanks space_mapping_ranks(
+  const SpaceT& raw_space, const PrepareF& prepare, const MapF& map,
+  RankBackend backend = RankBackend::exact
+) {
   Profiler profiler(false);
   const auto space = space_matrix(raw_space, prepare);
   profiler.finish("space");
-  const int space_rank = matrix_rank(space);
+  const int space_rank = matrix_rank(space, backend);
   profiler.finish("space rank");
   const auto image = space_matrix(raw_space, map);
   profiler.finish("image");
-  const int image_rank = matrix_rank(image);
+  const int image_rank = matrix_rank(image, backend);
   profiler.finish("image rank");
   return SpaceMappingRanks{space_rank, image_rank};
 }
@@ -0,0 +1,204 @@
+#include "spilled_matrix.h"
+
+#include <numeric>
+
+#include "check.h"
+#include "util.h"
+
+
+struct SpilledMatrixHeader {
+  char magic[8] = {'P', 'K', 'S', 'P', 'I', 'L', 'L', '\0'};
+  int32_t version = 1;
+  int32_t rows = 0;
+  int32_t cols = 0;
+  int32_t reserved = 0;
+  int64_t num_nonzero = 0;
+};
+static_assert(sizeof(SpilledMatrixHeader) == 32);
+static_assert(sizeof(SpilledElement) == 2 * sizeof(int32_t));
+
+
+SpilledMatrixWriter::SpilledMatrixWriter(const std::string& filename, int64_t buffer_bytes)
+  : fs_(filename, std::ios::binary), buffer_bytes_(buffer_bytes)
+{
+  CHECK(fs_.good()) << "Cannot open " << filename;
+  // Placeholder, will be overwritten in `finish`.
+  const SpilledMatrixHeader header;
+  fs_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+void SpilledMatrixWriter::add_col(std::vector<std::pair<int, int>> col) {
+  CHECK(!finished_);
+  absl::c_sort(col);
+  const auto size_pos = buffer_.size();
+  buffer_.push_back(0);
+  int32_t size = 0;
+  for (const auto& [row, value] : col) {
+    if (value != 0) {
+      buffer_.push_back(row);
+      buffer_.push_back(value);
+      ++size;
+    }
+  }
+  buffer_[size_pos] = size;
+  ++num_cols_;
+  num_nonzero_ += size;
+  if (buffer_.size() * sizeof(int32_t) >= buffer_bytes_) {
+    flush();
+  }
+}
+
+void SpilledMatrixWriter::flush() {
+  fs_.write(reinterpret_cast<const char*>(buffer_.data()), buffer_.size() * sizeof(int32_t));
+  CHECK(fs_.good());
+  buffer_.clear();
+}
+
+void SpilledMatrixWriter::finish(int num_rows) {
+  CHECK(!finished_);
+  flush();
+  SpilledMatrixHeader header;
+  header.rows = num_rows;
+  header.cols = num_cols_;
+  header.num_nonzero = num_nonzero_;
+  fs_.seekp(0);
+  fs_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  fs_.close();
+  CHECK(!fs_.fail());
+  finished_ = true;
+}
+
+
+SpilledMatrix::SpilledMatrix(const std::string& filename) : file_(filename) {
+  SpilledMatrixHeader header;
+  CHECK_GE(file_.size(), sizeof(header)) << "Not a spilled matrix: " << filename;
+  std::memcpy(&header, file_.data(), sizeof(header));
+  CHECK(std::equal(std::begin(header.magic), std::end(header.magic), SpilledMatrixHeader{}.magic))
+    << "Not a spilled matrix: " << filename;
+  CHECK_EQ(header.version, 1);
+  rows_ = header.rows;
+  cols_ = header.cols;
+  num_nonzero_ = header.num_nonzero;
+  data_offset_ = sizeof(header);
+  const int64_t expected_size = data_offset_ + cols_ * sizeof(int32_t) + num_nonzero_ * sizeof(SpilledElement);
+  CHECK_EQ(file_.size(), expected_size) << "Corrupted spilled matrix: " << filename;
+}
+
+CompressedMatrix SpilledMatrix::to_compressed_matrix() const {
+  std::vector<std::vector<CompressedMatrix::Element>> cols(cols_);
+  for_each_col([&](int col_index, Col col) {
+    for (const auto& e : col) {
+      cols[col_index].push_back({e.row, e.value});
+    }
+  });
+  return CompressedMatrix::from_sparse_cols(rows_, cols);
+}
+
+
+void save_triplets_binary(const std::string& filename, const CompressedMatrix& matrix) {
+  SpilledMatrixWriter writer(filename);
+  for (const int col : range(matrix.cols())) {
+    const auto line = matrix.col(col);
+    writer.add_col(std::vector(line.begin(), line.end()));
+  }
+  writer.finish(matrix.rows());
+}
+
+SpilledMatrix load_triplets_binary(const std::string& filename) {
+  return SpilledMatrix(filename);
+}
+
+void convert_triplets_to_binary(const std::string& text_filename, const std::string& binary_filename) {
+  save_triplets_binary(binary_filename, load_triplets(text_filename));
+}
+
+
+static int dsu_find(std::vector<int>& parent, int x) {
+  while (parent[x] != x) {
+    parent[x] = parent[parent[x]];
+    x = parent[x];
+  }
+  return x;
+}
+
+static void dsu_unite(std::vector<int>& parent, int a, int b) {
+  a = dsu_find(parent, a);
+  b = dsu_find(parent, b);
+  if (a != b) {
+    parent[std::max(a, b)] = std::min(a, b);
+  }
+}
+
+int matrix_rank_out_of_core(
+  const SpilledMatrix& matrix,
+  RankBackend backend,
+  int64_t max_nonzero_in_memory,
+  MatrixRankStats* stats
+) {
+  // Pass 1: find connected components of the bipartite graph with rows and columns as
+  // vertices, i.e. diagonal blocks. Vertices [0, rows) are rows, [rows, rows + cols) are columns.
+  const int rows = matrix.rows();
+  std::vector<int> parent(rows + matrix.cols());
+  std::iota(parent.begin(), parent.end(), 0);
+  matrix.for_each_col([&](int col_index, SpilledMatrix::Col col) {
+    for (const auto& e : col) {
+      dsu_unite(parent, rows + col_index, e.row);
+    }
+  });
+
+  // Split blocks into groups that fit into memory.
+  std::vector<int64_t> block_size(parent.size(), 0);  // indexed by root
+  matrix.for_each_col([&](int col_index, SpilledMatrix::Col col) {
+    block_size[dsu_find(parent, rows + col_index)] += col.size();
+  });
+  std::vector<int> block_group(parent.size(), -1);  // indexed by root
+  int num_groups = 0;
+  int64_t current_group_size = 0;
+  for (const int root : range(parent.size())) {
+    if (block_size[root] == 0) {
+      continue;
+    }
+    if (num_groups == 0 || current_group_size + block_size[root] > max_nonzero_in_memory) {
+      ++num_groups;
+      current_group_size = 0;
+    }
+    block_group[root] = num_groups - 1;
+    current_group_size += block_size[root];
+  }
+
+  // Pass 2+: load each group and compute its rank.
+  int rank = 0;
+  // Each row belongs to exactly one block, hence to one group, so there's no need to reset this.
+  std::vector<int> local_row(rows, -1);
+  if (stats) {
+    *stats = {};
+  }
+  for (const int group : range(num_groups)) {
+    std::vector<std::vector<CompressedMatrix::Element>> cols;
+    int num_local_rows = 0;
+    matrix.for_each_col([&](int col_index, SpilledMatrix::Col col) {
+      if (col.empty() || block_group[dsu_find(parent, rows + col_index)] != group) {
+        return;
+      }
+      auto& local_col = cols.emplace_back();
+      for (const auto& e : col) {
+        if (local_row[e.row] == -1) {
+          local_row[e.row] = num_local_rows++;
+        }
+        local_col.push_back({local_row[e.row], e.value});
+      }
+    });
+    MatrixRankStats group_stats;
+    rank += matrix_rank(CompressedMatrix::from_sparse_cols(num_local_rows, cols), backend, &group_stats);
+    if (stats) {
+      stats->num_threads = std::max(stats->num_threads, group_stats.num_threads);
+      append_vector(stats->blocks, std::move(group_stats.blocks));
+    }
+  }
+  if (stats) {
+    absl::c_stable_sort(stats->blocks, [](const auto& a, const auto& b) {
+      return a.num_nonzero > b.num_nonzero;
+    });
+  }
+  return rank;
+}
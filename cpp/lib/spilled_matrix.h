@@ -0,0 +1,116 @@
+// Out-of-core storage for large sparse matrices. Columns are written to a binary file as soon as
+// they are produced, and rank is computed by streaming through the file, so that the matrix never
+// has to be fully loaded into memory.
+//
+// The same format serves as a binary alternative to text triplets (`save_triplets`): it's about
+// half the size and can be used without parsing.
+//
+// File format (numbers are stored in native byte order):
+//   header: see `SpilledMatrixHeader` in spilled_matrix.cpp
+//   for each column:
+//     num_elements (int32)
+//     num_elements x (row (int32), value (int32)), sorted by row
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "absl/types/span.h"
+
+#include "linalg.h"
+#include "mapped_file.h"
+#include "range.h"
+
+
+struct SpilledElement {
+  int32_t row = 0;
+  int32_t value = 0;
+};
+
+// Writes columns to a file. Columns are buffered and flushed to disk in chunks.
+class SpilledMatrixWriter {
+public:
+  explicit SpilledMatrixWriter(const std::string& filename, int64_t buffer_bytes = 64 << 20);
+
+  int cols() const { return num_cols_; }
+  int64_t num_nonzero() const { return num_nonzero_; }
+
+  // Zeros are skipped. Rows must be unique within a column.
+  void add_col(std::vector<std::pair<int, int>> col);
+
+  // Must be called exactly once after all columns have been added. The number of rows is only
+  // known in the end, because it's usually determined by the monoms in the expressions.
+  void finish(int num_rows);
+
+private:
+  void flush();
+
+  std::ofstream fs_;
+  int64_t buffer_bytes_ = 0;
+  std::vector<int32_t> buffer_;
+  int num_cols_ = 0;
+  int64_t num_nonzero_ = 0;
+  bool finished_ = false;
+};
+
+// Read-only view of a file written by `SpilledMatrixWriter`.
+class SpilledMatrix {
+public:
+  using Col = absl::Span<const SpilledElement>;
+
+  explicit SpilledMatrix(const std::string& filename);
+
+  int rows() const { return rows_; }
+  int cols() const { return cols_; }
+  int64_t num_nonzero() const { return num_nonzero_; }
+
+  // Calls `func(col_index, col)` for each column in order.
+  template<typename F>
+  void for_each_col(const F& func) const {
+    const char* ptr = file_.data() + data_offset_;
+    for (const int col_index : range(cols_)) {
+      int32_t size;
+      std::memcpy(&size, ptr, sizeof(size));
+      ptr += sizeof(size);
+      func(col_index, Col(reinterpret_cast<const SpilledElement*>(ptr), size));
+      ptr += size * sizeof(SpilledElement);
+    }
+  }
+
+  // Loads the whole matrix into memory.
+  CompressedMatrix to_compressed_matrix() const;
+
+private:
+  MappedFile file_;
+  int64_t data_offset_ = 0;
+  int rows_ = 0;
+  int cols_ = 0;
+  int64_t num_nonzero_ = 0;
+};
+
+// Computes matrix rank without loading the whole matrix into memory. The file is streamed twice
+// or more: first to find diagonal blocks, then to load groups of blocks with at most
+// `max_nonzero_in_memory` elements in total (a single block that exceeds the limit is loaded on
+// its own). Each group is processed by `matrix_rank`.
+int matrix_rank_out_of_core(
+  const SpilledMatrix& matrix,
+  RankBackend backend = RankBackend::exact,
+  int64_t max_nonzero_in_memory = int64_t{1} << 28,
+  MatrixRankStats* stats = nullptr
+);
+
+// Binary counterpart of `save_triplets`.
+void save_triplets_binary(const std::string& filename, const CompressedMatrix& matrix);
+
+// Binary counterpart of `load_triplets`. The file is memory-mapped rather than read, so this is
+// instant regardless of the file size. Use `matrix_rank_out_of_core` to compute the rank or
+// `SpilledMatrix::to_compressed_matrix` to load the matrix into memory.
+SpilledMatrix load_triplets_binary(const std::string& filename);
+
+// Converts a file written by `save_triplets` to the binary format. Note: the matrix is loaded
+// into memory during the conversion.
+void convert_triplets_to_binary(const std::string& text_filename, const std::string& binary_filename);
@@ -9,6 +9,10 @@ std::string concat_strings(std::string a, std::string b) {
   return std::move(a) + std::move(b);
 }
 
+struct Int64StringParam : SimpleLinearParam<std::string> {
+  using CoeffT = int64_t;
+};
+
 
 TEST(OuterProductTest, TwoExpressions) {
   EXPECT_EXPR_EQ(
@@ -59,3 +63,16 @@ TEST(OuterProductTest, ThreeExpressions) {
     )
   );
 }
+
+TEST(OuterProductTest, Int64Coeffs) {
+  using ExprT = BasicLinear<Int64StringParam>;
+  const int64_t big = int64_t(1) << 20;
+  const ExprT product = outer_product<ExprT>(
+    big * ExprT::single("a"),
+    big * ExprT::single("b") - ExprT::single("c"),
+    concat_strings,
+    nullptr
+  );
+  EXPECT_EQ(product.coeff_for_key("ab"), big * big);
+  EXPECT_EQ(product.coeff_for_key("ac"), -big);
+}
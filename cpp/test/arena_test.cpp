@@ -0,0 +1,40 @@
+#include "lib/arena.h"
+
+#include "gtest/gtest.h"
+
+#include "lib/linear.h"
+#include "lib/range.h"
+
+
+using IntLinearParam = SimpleLinearParam<int>;
+
+TEST(ArenaTest, CurrentArena) {
+  auto* heap = ScopedArena::current();
+  {
+    ScopedArena outer;
+    auto* outer_resource = ScopedArena::current();
+    EXPECT_NE(outer_resource, heap);
+    {
+      ScopedArena inner;
+      EXPECT_NE(ScopedArena::current(), outer_resource);
+    }
+    EXPECT_EQ(ScopedArena::current(), outer_resource);
+  }
+  EXPECT_EQ(ScopedArena::current(), heap);
+}
+
+TEST(ArenaTest, ArenaBasicLinear) {
+  BasicLinear<IntLinearParam> expected;
+  BasicLinear<IntLinearParam> result;
+  {
+    ScopedArena arena;
+    ArenaBasicLinear<IntLinearParam> expr;
+    for (const int i : range(1000)) {
+      expr += (i % 7) * ArenaBasicLinear<IntLinearParam>::single(i % 100);
+      expected.add_to(i % 100, i % 7);
+    }
+    EXPECT_EQ(expr.num_terms(), expected.num_terms());
+    result = expr.cast_to<BasicLinear<IntLinearParam>>();
+  }
+  EXPECT_EQ(result, expected);
+}
@@ -0,0 +1,106 @@
+#include "lib/call_cache.h"
+
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "lib/range.h"
+
+
+TEST(CallCacheTest, Memoizes) {
+  CallCache<int, int, int> cache;
+  int num_calls = 0;
+  const auto func = [&](int a, int b) {
+    ++num_calls;
+    return a * b;
+  };
+  EXPECT_EQ(cache.apply(func, 2, 3), 6);
+  EXPECT_EQ(cache.apply(func, 3, 2), 6);
+  EXPECT_EQ(cache.apply(func, 2, 3), 6);
+  EXPECT_EQ(num_calls, 2);
+  const auto stats = cache.stats();
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 2);
+  EXPECT_EQ(stats.evictions, 0);
+  EXPECT_EQ(stats.num_entries, 2);
+  cache.clear();
+  EXPECT_EQ(cache.apply(func, 2, 3), 6);
+  EXPECT_EQ(num_calls, 3);
+}
+
+TEST(CallCacheTest, Recursive) {
+  CallCache<int64_t, int> cache;
+  const std::function<int64_t(int)> fib = [&](int n) -> int64_t {
+    return n < 2 ? n : cache.apply(fib, n - 1) + cache.apply(fib, n - 2);
+  };
+  EXPECT_EQ(cache.apply(fib, 80), 23416728348467685);
+  EXPECT_EQ(cache.stats().misses, 81);
+}
+
+TEST(CallCacheTest, Bounded) {
+  // Room for a few dozen vectors.
+  const size_t max_bytes = 32 * 1000;
+  CallCache<std::vector<int>, int> cache(max_bytes);
+  const auto func = [](int n) { return std::vector<int>(200, n); };
+  for (const int i : range(100000)) {
+    EXPECT_EQ(cache.apply(func, i).front(), i);
+  }
+  const auto stats = cache.stats();
+  EXPECT_GT(stats.evictions, 0);
+  EXPECT_EQ(stats.num_entries + stats.evictions, 100000);
+  EXPECT_LE(stats.bytes, max_bytes);
+}
+
+TEST(CallCacheTest, OversizedValuesAreNotStored) {
+  const size_t max_bytes = 10000;
+  CallCache<std::vector<int>, int> cache(max_bytes);
+  int num_calls = 0;
+  const auto func = [&](int n) {
+    ++num_calls;
+    return std::vector<int>(n, n);
+  };
+  cache.apply(func, 10);
+  cache.apply(func, 100000);
+  cache.apply(func, 100000);
+  cache.apply(func, 10);
+  EXPECT_EQ(num_calls, 3);
+  const auto stats = cache.stats();
+  EXPECT_EQ(stats.evictions, 0);
+  EXPECT_EQ(stats.num_entries, 1);
+  EXPECT_LE(stats.bytes, max_bytes);
+}
+
+TEST(CallCacheTest, SetMaxBytes) {
+  CallCache<std::vector<int>, int> cache(1000000);
+  const auto func = [](int n) { return std::vector<int>(200, n); };
+  for (const int i : range(1000)) {
+    cache.apply(func, i);
+  }
+  EXPECT_EQ(cache.stats().num_entries, 1000);
+  const size_t max_bytes = 32 * 1000;
+  cache.set_max_bytes(max_bytes);
+  const auto stats = cache.stats();
+  EXPECT_GT(stats.num_entries, 0);
+  EXPECT_EQ(stats.num_entries + stats.evictions, 1000);
+  EXPECT_LE(stats.bytes, max_bytes);
+}
+
+TEST(CallCacheTest, Concurrent) {
+  CallCache<int, int> cache;
+  const int num_keys = 1000;
+  std::vector<std::thread> threads;
+  for (const int t : range(4)) {
+    threads.emplace_back([&, t]() {
+      for (const int i : range(num_keys)) {
+        const int key = (i * (t + 1)) % num_keys;
+        EXPECT_EQ(cache.apply([](int x) { return x * x; }, key), key * key);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const auto stats = cache.stats();
+  EXPECT_EQ(stats.num_entries, num_keys);
+  EXPECT_EQ(stats.hits + stats.misses, 4 * num_keys);
+}
@@ -108,6 +108,84 @@ TEST(NComultiplyTest, IterationGivesZero) {
   )));
 }
 
+// Straightforward implementation: build a coproduct for every term.
+static SimpleVectorICoExpr icomultiply_reference(const SimpleVectorExpr& expr, std::vector<int> form) {
+  absl::c_sort(form);
+  SimpleVectorICoExpr ret;
+  expr.foreach([&](const std::vector<int>& word, int coeff) {
+    if (form.size() == 2) {
+      ret += coeff * icoproduct(SV(slice(word, 0, form[0])), SV(slice(word, form[0])));
+      if (form[0] != form[1]) {
+        ret -= coeff * icoproduct(SV(slice(word, form[1])), SV(slice(word, 0, form[1])));
+      }
+    } else {
+      std::vector<SimpleVectorExpr> parts;
+      int part_begin = 0;
+      for (const int part_weight : form) {
+        parts.push_back(SV(slice(word, part_begin, part_begin + part_weight)));
+        part_begin += part_weight;
+      }
+      ret += coeff * icoproduct_vec(parts);
+    }
+  });
+  return ret;
+}
+
+TEST(ComultiplyTest, MatchesReference) {
+  const auto expr =
+    + SV({1,2,3,4,5,6})
+    - SV({3,1,2,2,1,3})
+    + 2 * SV({4,2,4,1,1,2})
+    + SV({6,5,4,3,2,1})
+    - 3 * SV({2,1,2,1,2,1})
+  ;
+  for (const auto& form : std::vector<std::vector<int>>{{1,5}, {4,2}, {3,3}, {2,2,2}}) {
+    const auto expected = icomultiply_reference(expr, form);
+    EXPECT_FALSE(expected.is_zero());
+    EXPECT_EXPR_EQ(icomultiply(expr, form), expected);
+  }
+}
+
+// Straightforward implementation: build a coproduct for every cut.
+static SimpleVectorNCoExpr ncomultiply_reference(const SimpleVectorNCoExpr& coexpr) {
+  SimpleVectorNCoExpr ret;
+  coexpr.foreach([&](const std::vector<std::vector<int>>& parts, int coeff) {
+    for (const int i_cut_part : range(parts.size())) {
+      const auto& cut_part = parts[i_cut_part];
+      for (const int cut_pos : range(1, cut_part.size())) {
+        std::vector<SimpleVectorExpr> new_parts;
+        for (const int i_part : range(parts.size())) {
+          if (i_part == i_cut_part) {
+            new_parts.push_back(SV(slice(cut_part, 0, cut_pos)));
+            new_parts.push_back(SV(slice(cut_part, cut_pos)));
+          } else {
+            new_parts.push_back(SV(parts[i_part]));
+          }
+        }
+        ret += neg_one_pow(i_cut_part) * coeff * ncoproduct_vec(new_parts);
+      }
+    }
+  });
+  return ret;
+}
+
+TEST(NComultiplyTest, MatchesReference) {
+  const auto coexpr = ncoproduct(
+    + SV({1,2,3,4})
+    - SV({3,1,2,2})
+    + 2 * SV({4,2,4,1})
+    ,
+    + SV({5,6,5})
+    + SV({2,1,3})
+  );
+  const auto expected = ncomultiply_reference(coexpr);
+  ASSERT_FALSE(expected.is_zero());
+  EXPECT_EXPR_EQ(ncomultiply(coexpr), expected);
+  for (const auto& form : std::vector<std::vector<int>>{{1,1,5}, {1,3,3}, {3,2,2}, {4,2,1}}) {
+    EXPECT_EXPR_EQ(ncomultiply(coexpr, form), keep_coexpr_form(expected, form));
+  }
+}
+
 TEST(CoalgebraUtilTest, FilterCoExpr) {
   EXPECT_EXPR_EQ(
     filter_coexpr_predicate(
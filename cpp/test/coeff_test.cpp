@@ -0,0 +1,69 @@
+#include "lib/coeff.h"
+
+#include "gtest/gtest.h"
+
+#include "lib/linear.h"
+
+
+template<typename CoeffParamT>
+struct IntLinearParam : SimpleLinearParam<int> {
+  using CoeffT = CoeffParamT;
+};
+
+using ModP7 = ModP<7>;
+
+
+TEST(CoeffTest, ModP) {
+  EXPECT_EQ(ModP7(10), ModP7(3));
+  EXPECT_EQ(ModP7(-1), ModP7(6));
+  EXPECT_EQ(ModP7(3) + ModP7(5), ModP7(1));
+  EXPECT_EQ(ModP7(3) - ModP7(5), ModP7(5));
+  EXPECT_EQ(ModP7(3) * ModP7(5), ModP7(1));
+  EXPECT_EQ(ModP7(3).inverse(), ModP7(5));
+  EXPECT_EQ(ModP7(6).symmetric_value(), -1);
+  EXPECT_EQ(ModP7(3).symmetric_value(), 3);
+  EXPECT_EQ(coeff_div(ModP7(1), ModP7(3)), ModP7(5));
+  EXPECT_EQ(ModPCoeff(int64_t(1) << 40).value(), (int64_t(1) << 40) % ModPCoeff::kModulus);
+}
+
+TEST(CoeffTest, IntegerDivision) {
+  EXPECT_EQ(coeff_div<int64_t>(12, 4), 3);
+  EXPECT_THROW(coeff_div<int64_t>(12, 5), IntegerDivisionError);
+}
+
+TEST(CoeffTest, ToInt) {
+  EXPECT_EQ(coeff_to_int<int>(int64_t(5)), 5);
+  EXPECT_EQ(coeff_to_int<int>(int64_t(1) << 40), std::nullopt);
+  EXPECT_EQ(coeff_to_int<int>(ModP7(6)), -1);
+  EXPECT_EQ(coeff_to_int<int64_t>(static_cast<__int128>(1) << 100), std::nullopt);
+}
+
+TEST(CoeffTest, LinearInt64) {
+  using ExprT = Linear<IntLinearParam<int64_t>>;
+  const int64_t big = int64_t(1) << 40;
+  ExprT expr = big * ExprT::single(1) + ExprT::single(2);
+  expr *= 1000;
+  EXPECT_EQ(expr[1], big * 1000);
+  EXPECT_EQ(expr.l1_norm(), big * 1000 + 1000);
+  expr.div_int(1000);
+  EXPECT_EQ(expr[1], big);
+}
+
+TEST(CoeffTest, LinearModP) {
+  using ExprT = Linear<IntLinearParam<ModP7>>;
+  ExprT expr = 3 * ExprT::single(1) + 4 * ExprT::single(2);
+  EXPECT_EQ(expr[1], ModP7(3));
+  expr += 4 * ExprT::single(1);
+  EXPECT_EQ(expr.num_terms(), 1);
+  expr.div_int(4);
+  EXPECT_EQ(expr[2], ModP7(1));
+}
+
+#if ENABLE_ASSERTIONS
+TEST(CoeffDeathTest, Overflow) {
+  using ExprT = BasicLinear<IntLinearParam<int>>;
+  const ExprT expr = std::numeric_limits<int>::max() * ExprT::single(1);
+  EXPECT_DEATH(expr + expr, "overflow");
+  EXPECT_DEATH(expr * 2, "overflow");
+}
+#endif
@@ -13,6 +13,11 @@ inline StringExpr SS(const std::string& s) {
 
 using CoordValue = std::pair<int, int>;
 
+template<typename CoeffParamT>
+struct IntLinearParam : SimpleLinearParam<int> {
+  using CoeffT = CoeffParamT;
+};
+
 Matrix matrix(const std::vector<std::vector<int>>& values) {
   Matrix ret(values.size(), values.at(0).size());
   for (const int i_row : range(values.size())) {
@@ -112,3 +117,55 @@ TEST(ExprMatrixBuilderTest, MixedTypes) {
     })
   );
 }
+
+TEST(ExprMatrixBuilderTest, ConcurrentSameAsSequential) {
+  std::vector<std::tuple<SimpleVectorExpr, StringExpr>> exprs;
+  std::vector<std::vector<SimpleVectorExpr>> expr_vectors;
+  for (const int i : range(200)) {
+    const auto a = SV({i % 7}) + 2 * SV({i % 11, i % 3});
+    const auto b = SS(std::to_string(i % 13)) - SS(std::to_string(i % 5));
+    exprs.push_back({a, b});
+    expr_vectors.push_back({a, SV({i % 17})});
+  }
+
+  ExprTupleMatrixBuilder<SimpleVectorExpr, StringExpr> tuple_builder;
+  ConcurrentExprMatrixBuilder<std::tuple<SimpleVectorExpr, StringExpr>> concurrent_tuple_builder;
+  for (const auto& expr : exprs) {
+    tuple_builder.add_expr(expr);
+  }
+  concurrent_tuple_builder.add_exprs(exprs);
+  EXPECT_MATRIX_EQ(std::move(concurrent_tuple_builder).make_matrix(), tuple_builder.make_matrix());
+
+  ExprVectorMatrixBuilder<SimpleVectorExpr> vector_builder;
+  ConcurrentExprMatrixBuilder<std::vector<SimpleVectorExpr>> concurrent_vector_builder;
+  for (const auto& expr : expr_vectors) {
+    vector_builder.add_expr(expr);
+  }
+  concurrent_vector_builder.add_exprs(expr_vectors);
+  EXPECT_MATRIX_EQ(std::move(concurrent_vector_builder).make_matrix(), vector_builder.make_matrix());
+}
+
+TEST(ExprMatrixBuilderTest, ModPCoeffs) {
+  using ExprT = Linear<IntLinearParam<ModPCoeff>>;
+  ExprTupleMatrixBuilder<ExprT> matrix_builder;
+  matrix_builder.add_expr(ExprT::single(1) - ExprT::single(2));
+  matrix_builder.add_expr(3 * ExprT::single(2));
+  EXPECT_MATRIX_EQ(
+    matrix_builder.make_matrix(),
+    matrix({
+      { -1,  3 },
+      {  1,  0 },
+    })
+  );
+}
+
+TEST(ExprMatrixBuilderTest, Int64Coeffs) {
+  using ExprT = Linear<IntLinearParam<int64_t>>;
+  const int64_t big = int64_t(1) << 40;
+  ExprTupleMatrixBuilder<ExprT> matrix_builder;
+  // Coefficients that fit into a matrix element are converted as is.
+  matrix_builder.add_expr((big + 2) * ExprT::single(1) - big * ExprT::single(1));
+  EXPECT_MATRIX_EQ(matrix_builder.make_matrix(), matrix({{ 2 }}));
+  // Larger coefficients are not narrowed silently.
+  EXPECT_DEATH(matrix_builder.add_expr(big * ExprT::single(2)), "too large for a matrix element");
+}
@@ -0,0 +1,63 @@
+#include "lib/flat_nested_vector.h"
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include "absl/hash/hash_testing.h"
+
+#include "lib/util.h"
+
+
+using testing::ElementsAre;
+
+using Parts = std::vector<std::vector<uint16_t>>;
+using Vec = FlatNestedVector<uint16_t, flat_nested_vector_bytes<uint16_t>(2, 4)>;
+
+static const std::vector<Parts> kTestVectors = {
+  {},
+  {{}},
+  {{}, {}},
+  {{1}},
+  {{1}, {}},
+  {{}, {1}},
+  {{1, 2}},
+  {{1}, {2}},
+  {{1, 2}, {3}},
+  {{1}, {2, 3}},
+  {{1, 2, 3}},
+  {{1, 2, 3, 4, 5, 6, 7}, {8, 9, 10}, {11}},
+  {{1000, 2000}, {3000}},
+};
+
+
+TEST(FlatNestedVectorTest, Parts) {
+  const Vec v = Vec::from_parts(Parts{{1, 2}, {}, {3}});
+  EXPECT_EQ(v.num_parts(), 3);
+  EXPECT_THAT(v.part(0), ElementsAre(1, 2));
+  EXPECT_THAT(v.part(1), ElementsAre());
+  EXPECT_THAT(v.part(2), ElementsAre(3));
+  EXPECT_EQ(v.to_parts<Parts>(), (Parts{{1, 2}, {}, {3}}));
+}
+
+TEST(FlatNestedVectorTest, CompareAsVectors) {
+  for (const auto& a : kTestVectors) {
+    for (const auto& b : kTestVectors) {
+      EXPECT_EQ(Vec::from_parts(a) == Vec::from_parts(b), a == b) << dump_to_string(a) << " vs " << dump_to_string(b);
+      EXPECT_EQ(Vec::from_parts(a) < Vec::from_parts(b), a < b) << dump_to_string(a) << " vs " << dump_to_string(b);
+    }
+  }
+}
+
+TEST(FlatNestedVectorTest, Hash) {
+  EXPECT_TRUE(absl::VerifyTypeImplementsAbslHashCorrectly(mapped(kTestVectors, [](const Parts& parts) {
+    return Vec::from_parts(parts);
+  })));
+}
+
+TEST(FlatNestedVectorTest, Concat) {
+  for (const auto& a : kTestVectors) {
+    for (const auto& b : kTestVectors) {
+      EXPECT_EQ(concat(Vec::from_parts(a), Vec::from_parts(b)), Vec::from_parts(concat(a, b)));
+    }
+  }
+}
@@ -0,0 +1,52 @@
+#include "lib/frozen_linear.h"
+
+#include "gtest/gtest.h"
+
+#include "lib/expr_matrix_builder.h"
+#include "lib/polylog_qli.h"
+#include "lib/polylog_type_ac_space.h"
+#include "lib/space_algebra.h"
+#include "test_util/matchers.h"
+
+
+TEST(FrozenLinearTest, ReadApi) {
+  const DeltaExpr expr = QLi3(1, 2, 3, 4, 5, 6);
+  const FrozenLinear frozen(expr);
+  EXPECT_EQ(frozen.num_terms(), expr.num_terms());
+  EXPECT_EQ(frozen.weight(), expr.weight());
+  expr.foreach_key([&](const auto& key, int coeff) {
+    EXPECT_EQ(frozen.coeff_for_key(key), coeff);
+  });
+  int num_terms = 0;
+  for (const auto& [term, coeff] : frozen) {
+    EXPECT_EQ(expr[term], coeff);
+    ++num_terms;
+  }
+  EXPECT_EQ(num_terms, expr.num_terms());
+  EXPECT_EQ(frozen.coeff_for_key(DeltaExpr::Param::object_to_key({Delta(x1, x3)})), 0);
+  EXPECT_EXPR_EQ(frozen.thawed(), expr);
+  EXPECT_EQ(frozen.annotations().expression, expr.annotations().expression);
+}
+
+TEST(FrozenLinearTest, Empty) {
+  const FrozenLinear frozen{DeltaExpr()};
+  EXPECT_TRUE(frozen.is_zero());
+  EXPECT_TRUE(frozen.is_blank());
+  EXPECT_EXPR_EQ(frozen.thawed(), DeltaExpr());
+  EXPECT_DEATH(frozen.element(), "");
+}
+
+TEST(FrozenLinearTest, SpaceRank) {
+  const auto space = CB3({1, 2, 3, 4, 5, 6});
+  const auto frozen_space = freeze_space(space);
+  EXPECT_EQ(
+    space_rank(frozen_space, std::identity{}),
+    space_rank(space, std::identity{})
+  );
+
+  ExprVectorMatrixBuilder<FrozenLinear<DeltaExpr::Param>> frozen_builder;
+  ExprVectorMatrixBuilder<DeltaExpr> builder;
+  frozen_builder.add_expr(slice(frozen_space, 0, 3));
+  builder.add_expr(slice(space, 0, 3));
+  EXPECT_EQ(matrix_rank(frozen_builder.make_matrix()), matrix_rank(builder.make_matrix()));
+}
@@ -0,0 +1,48 @@
+#include "lib/incremental_rank.h"
+
+#include "gtest/gtest.h"
+
+
+class IncrementalRankTest : public testing::TestWithParam<RankBackend> {};
+
+TEST_P(IncrementalRankTest, Rank) {
+  IncrementalRankBuilder builder(GetParam());
+  EXPECT_EQ(builder.rank(), 0);
+  EXPECT_TRUE(builder.add_col({{0, 1}, {1, 2}}));
+  EXPECT_TRUE(builder.add_col({{1, -1}, {2, 3}}));
+  EXPECT_FALSE(builder.add_col({{2, 3}, {0, 2}, {1, 3}}));
+  EXPECT_FALSE(builder.add_col({}));
+  EXPECT_FALSE(builder.add_col({{5, 0}}));
+  EXPECT_TRUE(builder.add_col({{3, 7}}));
+  EXPECT_EQ(builder.rank(), 3);
+  EXPECT_EQ(builder.num_cols(), 6);
+}
+
+TEST_P(IncrementalRankTest, Contains) {
+  IncrementalRankBuilder builder(GetParam());
+  builder.add_col({{0, 2}, {1, 4}});
+  builder.add_col({{1, 1}, {2, 1}});
+  EXPECT_TRUE(builder.contains({{0, 1}, {1, 2}}));
+  EXPECT_TRUE(builder.contains({{0, 2}, {1, 2}, {2, -2}}));
+  EXPECT_FALSE(builder.contains({{0, 1}}));
+  EXPECT_FALSE(builder.contains({{3, 1}}));
+  EXPECT_EQ(builder.rank(), 2);
+}
+
+TEST_P(IncrementalRankTest, Decompose) {
+  IncrementalRankBuilder builder(GetParam(), /* track_combinations = */ true);
+  builder.add_col({{0, 1}});
+  builder.add_col({{0, 2}});  // dependent
+  builder.add_col({{1, 1}});
+  builder.add_col({{0, 1}, {2, 3}});
+  EXPECT_EQ(builder.decompose({{1, 5}}), std::vector{2});
+  EXPECT_EQ(builder.decompose({{0, 1}, {1, 1}}), (std::vector{0, 2}));
+  EXPECT_EQ(builder.decompose({{2, 6}}), (std::vector{0, 3}));
+  EXPECT_EQ(builder.decompose({}), std::vector<int>{});
+  EXPECT_EQ(builder.decompose({{3, 1}}), std::nullopt);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  AllBackends, IncrementalRankTest,
+  testing::Values(RankBackend::exact, RankBackend::modular)
+);
@@ -0,0 +1,106 @@
+#include "lib/linalg_modular.h"
+
+#include "gtest/gtest.h"
+
+#include "lib/range.h"
+
+
+// Computes rank over rationals via dense Gaussian elimination. Only for small matrices.
+static int dense_rank(const Matrix& matrix) {
+  std::vector<std::vector<double>> a(matrix.rows(), std::vector<double>(matrix.cols()));
+  for (const auto& t : matrix.as_triplets()) {
+    a[t.row][t.col] = t.value;
+  }
+  int rank = 0;
+  for (const int col : range(matrix.cols())) {
+    int pivot = -1;
+    for (const int row : range(rank, matrix.rows())) {
+      if (std::abs(a[row][col]) > 1e-9) {
+        pivot = row;
+        break;
+      }
+    }
+    if (pivot == -1) {
+      continue;
+    }
+    std::swap(a[pivot], a[rank]);
+    for (const int row : range(matrix.rows())) {
+      if (row != rank) {
+        const double factor = a[row][col] / a[rank][col];
+        for (const int c : range(matrix.cols())) {
+          a[row][c] -= factor * a[rank][c];
+        }
+      }
+    }
+    ++rank;
+  }
+  return rank;
+}
+
+
+TEST(LinalgModularTest, Empty) {
+  EXPECT_EQ(matrix_rank_mod_prime(Matrix(0, 0), kRankPrimes[0]), 0);
+  EXPECT_EQ(matrix_rank_mod_prime(Matrix(3, 5), kRankPrimes[0]), 0);
+}
+
+TEST(LinalgModularTest, ExplicitZeros) {
+  Matrix m(2, 2);
+  m(0, 0) = 0;
+  m(1, 1) = 0;
+  EXPECT_EQ(matrix_rank_mod_prime(m, kRankPrimes[0]), 0);
+}
+
+TEST(LinalgModularTest, Dependent) {
+  Matrix m(3, 3);
+  m(0, 0) = 1;  m(0, 1) = 2;
+  m(1, 1) = -1; m(1, 2) = 3;
+  m(2, 0) = 2;  m(2, 1) = 3;  m(2, 2) = 3;
+  EXPECT_EQ(matrix_rank_mod_prime(m, kRankPrimes[0]), 2);
+  EXPECT_EQ(matrix_rank_mod_prime(m.transposed(), kRankPrimes[0]), 2);
+}
+
+TEST(LinalgModularTest, SmallPrimeDropsRank) {
+  Matrix m(2, 2);
+  m(0, 0) = 1;  m(0, 1) = 1;
+  m(1, 0) = 1;  m(1, 1) = -1;
+  EXPECT_EQ(matrix_rank_mod_prime(m, kRankPrimes[0]), 2);
+  EXPECT_EQ(matrix_rank_mod_prime(m, 2), 1);
+}
+
+TEST(LinalgModularTest, PseudoRandom) {
+  for (const int seed : range(20)) {
+    const int rows = 5 + seed % 7;
+    const int cols = 4 + seed % 5;
+    Matrix m(rows, cols);
+    // Low-rank matrix: each row is a combination of a few base rows.
+    const int num_base = 1 + seed % 4;
+    uint32_t state = seed + 1;
+    const auto next = [&]() {
+      state = state * 1103515245u + 12345u;
+      return static_cast<int>((state >> 16) % 7) - 3;
+    };
+    std::vector<std::vector<int>> base(num_base, std::vector<int>(cols));
+    for (auto& row : base) {
+      for (auto& v : row) {
+        v = next();
+      }
+    }
+    for (const int r : range(rows)) {
+      std::vector<int> row(cols);
+      for (const auto& b : base) {
+        const int k = next();
+        for (const int c : range(cols)) {
+          row[c] += k * b[c];
+        }
+      }
+      for (const int c : range(cols)) {
+        if (row[c] != 0) {
+          m(r, c) = row[c];
+        }
+      }
+    }
+    for (const uint32_t prime : kRankPrimes) {
+      EXPECT_EQ(matrix_rank_mod_prime(m, prime), dense_rank(m)) << "seed " << seed;
+    }
+  }
+}
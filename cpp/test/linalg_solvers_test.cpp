@@ -2,6 +2,7 @@
 
 #include "gtest/gtest.h"
 
+#include "lib/linalg_modular.h"
 #include "lib/polylog_gr_space.h"
 #include "lib/polylog_type_ac_space.h"
 #include "lib/polylog_qli.h"
@@ -20,3 +21,29 @@ TEST(LinalgSolversTest, SpaceBasis) {
   check_space(GrL1(3, {1,2,3,4,5,6}));
   check_space(GrL2(3, {1,2,3,4,5,6}));
 }
+
+TEST(LinalgSolversTest, MinimalContainingSubspace) {
+  const std::vector haystack = {
+    QLi1(1,2,3,4),
+    QLi1(1,2,3,5),
+    QLi1(1,2,3,4) + QLi1(1,2,3,5),
+    QLi1(1,2,4,5),
+    QLi1(1,2,3,6),
+  };
+  const std::vector needle = {QLi1(1,2,3,4) - QLi1(1,2,4,5)};
+  const auto subspace = minimal_containing_subspace(haystack, needle);
+  EXPECT_EQ(subspace.size(), 2);
+  EXPECT_TRUE(space_contains(subspace, needle, std::identity{}));
+  for (const int idx : range(subspace.size())) {
+    EXPECT_FALSE(space_contains(removed_index(subspace, idx), needle, std::identity{}));
+  }
+}
+
+// Expressions that are linearly independent over integers, but not modulo `kRankPrimes[0]`.
+TEST(LinalgSolversTest, PrimeMultiples) {
+  const int p = kRankPrimes[0];
+  const std::vector space = {QLi1(1,2,3,4), p * QLi1(1,2,3,5)};
+  EXPECT_EQ(space_basis(space, std::identity{}).size(), 2);
+  const std::vector needle = {p * QLi1(1,2,3,5)};
+  EXPECT_EQ(minimal_containing_subspace(space, needle), needle);
+}
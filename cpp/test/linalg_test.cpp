@@ -0,0 +1,73 @@
+#include "lib/linalg.h"
+
+#include "gtest/gtest.h"
+
+#include "lib/range.h"
+
+
+// Block diagonal matrix with blocks of size 1, 2, ..., `num_blocks`. Block of size `n` has rank `n-1`
+// (consecutive differences), except for the block of size 1 which has rank 1.
+static Matrix make_block_diagonal_matrix(int num_blocks) {
+  const int size = num_blocks * (num_blocks + 1) / 2;
+  Matrix m(size, size);
+  int offset = 0;
+  for (const int n : range_incl(1, num_blocks)) {
+    if (n == 1) {
+      m(offset, offset) = 3;
+    } else {
+      for (const int i : range(n - 1)) {
+        m(offset + i, offset + i) = 1;
+        m(offset + i, offset + i + 1) = -1;
+      }
+    }
+    offset += n;
+  }
+  return m;
+}
+
+
+class MatrixRankTest : public testing::TestWithParam<RankBackend> {};
+
+TEST_P(MatrixRankTest, Empty) {
+  EXPECT_EQ(matrix_rank(Matrix(0, 0), GetParam()), 0);
+  EXPECT_EQ(matrix_rank(Matrix(4, 3), GetParam()), 0);
+}
+
+TEST_P(MatrixRankTest, BlockDiagonal) {
+  const int num_blocks = 10;
+  MatrixRankStats stats;
+  EXPECT_EQ(matrix_rank(make_block_diagonal_matrix(num_blocks), GetParam(), &stats), 1 + 45);
+  EXPECT_GE(stats.num_threads, 1);
+  ASSERT_EQ(stats.blocks.size(), num_blocks);
+  for (const int i : range(1, stats.blocks.size())) {
+    EXPECT_GE(stats.blocks[i - 1].num_nonzero, stats.blocks[i].num_nonzero);
+  }
+}
+
+TEST_P(MatrixRankTest, SingleThread) {
+  set_matrix_rank_num_threads(1);
+  MatrixRankStats stats;
+  EXPECT_EQ(matrix_rank(make_block_diagonal_matrix(5), GetParam(), &stats), 1 + 10);
+  EXPECT_EQ(stats.num_threads, 1);
+  set_matrix_rank_num_threads(0);
+}
+
+TEST_P(MatrixRankTest, NoMoreThreadsThanBlocks) {
+  set_matrix_rank_num_threads(64);
+  MatrixRankStats stats;
+  EXPECT_EQ(matrix_rank(make_block_diagonal_matrix(5), GetParam(), &stats), 1 + 10);
+  EXPECT_EQ(stats.num_threads, 5);
+  set_matrix_rank_num_threads(0);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  AllBackends, MatrixRankTest,
+  testing::Values(RankBackend::exact, RankBackend::modular)
+);
+
+
+TEST(FindKernelVectorTest, ZeroMatrix) {
+  EXPECT_EQ(find_kernel_vector(Matrix(2, 3)), (std::vector{1, 0, 0}));
+  EXPECT_EQ(find_kernel_vector(Matrix(0, 2)), (std::vector{1, 0}));
+  EXPECT_EQ(find_kernel_vector(Matrix(2, 0)), std::vector<int>{});
+}
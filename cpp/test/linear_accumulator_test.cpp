@@ -0,0 +1,50 @@
+#include "lib/linear.h"
+
+#include "gtest/gtest.h"
+
+#include "lib/arena.h"
+#include "lib/range.h"
+
+
+using IntLinearParam = SimpleLinearParam<int>;
+
+TEST(LinearAccumulatorTest, SameAsAddToKey) {
+  BasicLinear<IntLinearParam> expected;
+  LinearAccumulator<IntLinearParam> acc;
+  for (const int i : range(10000)) {
+    const int key = (i * 7919) % 3000;
+    const int coeff = i % 5 - 2;
+    expected.add_to_key(key, coeff);
+    acc.add_to_key(key, coeff);
+  }
+  EXPECT_EQ(acc.materialize(), expected);
+  EXPECT_TRUE(acc.empty());
+}
+
+TEST(LinearAccumulatorTest, Cancellation) {
+  const auto expr = BasicLinear<IntLinearParam>::from_collection(range(1000));
+  LinearAccumulator<IntLinearParam> acc;
+  acc.add_expr(expr, 2);
+  acc.add_to_key(-1, 1);
+  acc.add_expr(expr, -2);
+  const auto result = acc.materialize();
+  EXPECT_EQ(result, BasicLinear<IntLinearParam>::single(-1));
+  EXPECT_EQ(result.num_terms(), 1);
+}
+
+TEST(LinearAccumulatorTest, Arena) {
+  BasicLinear<IntLinearParam> result;
+  {
+    ScopedArena arena;
+    ArenaBasicLinear<IntLinearParam>::Accumulator acc;
+    for (const int i : range(1000)) {
+      acc.add_expr(ArenaBasicLinear<IntLinearParam>::single(i % 100), i % 7);
+    }
+    result = acc.materialize().cast_to<BasicLinear<IntLinearParam>>();
+  }
+  BasicLinear<IntLinearParam> expected;
+  for (const int i : range(1000)) {
+    expected.add_to(i % 100, i % 7);
+  }
+  EXPECT_EQ(result, expected);
+}
@@ -118,3 +118,54 @@ TEST(LyndonBasisTest, Size3) {
     - SV({5,6,7})
   );
 }
+
+TEST(LyndonBasisTest, Memoized) {
+  const auto expr =
+    + SV({3,1,2,1})
+    - SV({2,2,1,2,1})
+    + SV({1,4,1,4,1,4})
+    + SV({9,7,8,7,9,8,7})
+    // Too long to memoize. Has a short expansion in both letter orders.
+    + 2 * SV(mapped(range(internal::kMaxLyndonMemoWordLength + 1), [](int i) {
+      return i == 0 ? 1 : 0;
+    }))
+  ;
+  const auto inversed = expr.mapped<InversedVectorExpr>([](const auto& w) { return w; });
+  set_lyndon_memo_enabled(false);
+  const auto expected = to_lyndon_basis(expr);
+  const auto expected_inversed = to_lyndon_basis(inversed);
+  set_lyndon_memo_enabled(true);
+  EXPECT_EXPR_EQ(to_lyndon_basis(expr), expected);
+  EXPECT_EXPR_EQ(to_lyndon_basis(inversed), expected_inversed);
+  // Same shape: memoized expansion should be reused with different letters.
+  EXPECT_EXPR_EQ(
+    to_lyndon_basis(SV({6,2,4,2})),
+    to_lyndon_basis(SV({3,1,2,1})).mapped([](const auto& w) {
+      return mapped(w, [](int x) { return 2 * x; });
+    })
+  );
+}
+
+TEST(LyndonBasisTest, MemoBudget) {
+  const auto expr = SV({3,1,2,1}) - SV({2,2,1,2,1}) + SV({9,7,8,7,9,8,7});
+  set_lyndon_memo_enabled(false);
+  const auto expected = to_lyndon_basis(expr);
+  set_lyndon_memo_enabled(true);
+  // Every expansion exceeds the budget, so nothing is stored.
+  clear_lyndon_memo();
+  set_lyndon_memo_max_bytes(1);
+  EXPECT_EXPR_EQ(to_lyndon_basis(expr), expected);
+  EXPECT_EXPR_EQ(to_lyndon_basis(expr), expected);
+  set_lyndon_memo_max_bytes(size_t(256) << 20);
+  EXPECT_EXPR_EQ(to_lyndon_basis(expr), expected);
+}
+
+TEST(LyndonBasisTest, Parallel) {
+  SimpleVectorExpr expr;
+  for (const int idx : range(1 << 10)) {
+    // All words of length 5 over a 4-letter alphabet.
+    const auto word = mapped(range(5), [&](int pos) { return (idx >> (2 * pos)) % 4; });
+    expr += (idx % 5 - 2) * SV(word);
+  }
+  EXPECT_EXPR_EQ(to_lyndon_basis_parallel(expr, 4), to_lyndon_basis(expr));
+}
@@ -1,5 +1,7 @@
 #include "lib/matrix.h"
 
+#include <fstream>
+
 #include "gtest/gtest.h"
 
 #include "lib/range.h"
@@ -136,3 +138,55 @@ TEST(MatrixTest, Sorting) {
 
   EXPECT_MATRIX_EQ(sort_unique_rows(m), s);
 }
+
+TEST(CompressedMatrixTest, FromMatrix) {
+  Matrix m(3, 4);
+  m(2, 3) = 5;
+  m(0, 1) = 1;
+  m(2, 0) = -2;
+  m(1, 1) = 0;
+  m(0, 3) = 7;
+  const CompressedMatrix c(m);
+  EXPECT_EQ(c.shape(), std::pair(3, 4));
+  EXPECT_EQ(c.num_nonzero(), 4);
+  using Elements = std::vector<CompressedMatrix::Element>;
+  EXPECT_EQ(Elements(c.row(0).begin(), c.row(0).end()), (Elements{{1, 1}, {3, 7}}));
+  EXPECT_TRUE(c.row(1).empty());
+  EXPECT_EQ(Elements(c.row(2).begin(), c.row(2).end()), (Elements{{0, -2}, {3, 5}}));
+  EXPECT_EQ(Elements(c.col(3).begin(), c.col(3).end()), (Elements{{0, 7}, {2, 5}}));
+  EXPECT_TRUE(c.col(2).empty());
+  EXPECT_MATRIX_EQ(c.to_matrix().transposed(), c.transposed().to_matrix());
+  EXPECT_MATRIX_EQ(c.transposed().transposed(), c);
+}
+
+TEST(CompressedMatrixTest, FromSparseCols) {
+  const auto c = CompressedMatrix::from_sparse_cols(3, {{{2, 1}, {0, 4}}, {}, {{1, 3}}});
+  Matrix m(3, 3);
+  m(0, 0) = 4;
+  m(2, 0) = 1;
+  m(1, 2) = 3;
+  EXPECT_MATRIX_EQ(c, m);
+  EXPECT_MATRIX_EQ(CompressedMatrix::from_sparse_rows(3, {{{0, 4}}, {{2, 3}}, {{0, 1}}}), m);
+}
+
+TEST(CompressedMatrixTest, Equality) {
+  EXPECT_EQ(CompressedMatrix(2, 3), CompressedMatrix(2, 3));
+  EXPECT_NE(CompressedMatrix(2, 3), CompressedMatrix(4, 3));
+  EXPECT_NE(CompressedMatrix(2, 3), CompressedMatrix(2, 4));
+  Matrix m(2, 3);
+  m(1, 2) = 5;
+  EXPECT_EQ(CompressedMatrix(m), CompressedMatrix::from_triplets({2, 3}, {{1, 2, 5}}));
+  EXPECT_NE(CompressedMatrix(m), CompressedMatrix::from_triplets({3, 3}, {{1, 2, 5}}));
+}
+
+TEST(CompressedMatrixTest, LoadTripletsDuplicates) {
+  const std::string filename = testing::TempDir() + "duplicate_triplets.txt";
+  {
+    std::ofstream fs(filename);
+    fs << "3 3\n5\n0 1 4\n2 2 1\n0 1 -3\n1 0 2\n2 2 0\n";
+  }
+  Matrix m(3, 3);
+  m(0, 1) = -3;
+  m(1, 0) = 2;
+  EXPECT_MATRIX_EQ(load_triplets(filename), m);
+}
@@ -0,0 +1,34 @@
+#include "lib/merging_heap.h"
+
+#include "gtest/gtest.h"
+
+#include "lib/range.h"
+
+
+TEST(MergingHeapTest, PopsInDescendingOrder) {
+  MergingHeap<int, int> heap;
+  for (const int key : {3, 1, 4, 1, 5, 9, 2, 6}) {
+    heap.push(key, 1);
+  }
+  EXPECT_EQ(heap.size(), 7);
+  std::vector<std::pair<int, int>> popped;
+  while (!heap.empty()) {
+    popped.push_back(heap.pop());
+  }
+  EXPECT_EQ(popped, (std::vector<std::pair<int, int>>{
+    {9, 1}, {6, 1}, {5, 1}, {4, 1}, {3, 1}, {2, 1}, {1, 2},
+  }));
+}
+
+TEST(MergingHeapTest, MergesValues) {
+  MergingHeap<std::vector<int>, int, std::greater<>> heap;
+  heap.push({1, 2}, 3);
+  heap.push({2}, 1);
+  heap.push({1, 2}, -3);
+  heap.push({2}, 4);
+  EXPECT_EQ(heap.pop(), std::pair(std::vector{1, 2}, 0));
+  heap.push({1}, 7);
+  EXPECT_EQ(heap.pop(), std::pair(std::vector{1}, 7));
+  EXPECT_EQ(heap.pop(), std::pair(std::vector{2}, 5));
+  EXPECT_TRUE(heap.empty());
+}
@@ -0,0 +1,76 @@
+#include "lib/packed_vector.h"
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include "absl/hash/hash_testing.h"
+
+#include "lib/util.h"
+
+
+using testing::ElementsAre;
+
+using Vec = PackedVector<unsigned char, 8>;
+
+static Vec V(std::vector<unsigned char> data) {
+  return Vec(data.begin(), data.end());
+}
+
+static const std::vector<std::vector<unsigned char>> kTestVectors = {
+  {},
+  {0},
+  {0, 0},
+  {1},
+  {1, 0},
+  {0, 1},
+  {1, 2, 3},
+  {1, 2, 4},
+  {1, 2, 3, 0},
+  {255},
+  {255, 0, 255},
+  {1, 2, 3, 4, 5, 6, 7},
+  {1, 2, 3, 4, 5, 6, 7, 0},
+  {1, 2, 3, 4, 5, 6, 7, 8},
+  {1, 2, 3, 4, 5, 6, 7, 255},
+};
+
+
+TEST(PackedVectorTest, Basic) {
+  Vec v;
+  EXPECT_TRUE(v.empty());
+  v.push_back(3);
+  v.push_back(1);
+  EXPECT_THAT(v, ElementsAre(3, 1));
+  EXPECT_EQ(v.word(), 0x0103);
+  v.pop_back();
+  EXPECT_EQ(v, V({3}));
+  EXPECT_EQ(v.word(), 0x03);
+}
+
+TEST(PackedVectorTest, CompareAsVectors) {
+  for (const auto& a : kTestVectors) {
+    for (const auto& b : kTestVectors) {
+      EXPECT_EQ(V(a) == V(b), a == b) << dump_to_string(a) << " vs " << dump_to_string(b);
+      EXPECT_EQ(V(a) < V(b), a < b) << dump_to_string(a) << " vs " << dump_to_string(b);
+    }
+  }
+}
+
+TEST(PackedVectorTest, Hash) {
+  EXPECT_TRUE(absl::VerifyTypeImplementsAbslHashCorrectly(mapped(kTestVectors, V)));
+}
+
+TEST(PackedVectorTest, ConcatAndSlice) {
+  for (const auto& a : kTestVectors) {
+    for (const auto& b : kTestVectors) {
+      if (a.size() + b.size() <= Vec::kCapacity) {
+        EXPECT_EQ(concat(V(a), V(b)), V(concat(a, b)));
+      }
+    }
+    for (int from : range_incl(0, a.size())) {
+      for (int to : range_incl(from, a.size())) {
+        EXPECT_EQ(slice(V(a), from, to), V(slice(a, from, to)));
+      }
+    }
+  }
+}
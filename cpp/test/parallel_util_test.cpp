@@ -10,3 +10,30 @@ TEST(ParallelUtilTest, MappedParallel) {
     testing::ElementsAre(2, 4, 6, 8, 10, 12, 14, 16)
   );
 }
+
+TEST(ParallelUtilTest, ParallelForWorkStealing) {
+  for (const int num_threads : {0, 1, 3, 16}) {
+    const int num_tasks = 100;
+    std::vector<int> results(num_tasks);
+    parallel_for_work_stealing(num_tasks, num_threads, [&](int i) {
+      results[i] += i * i;
+    });
+    for (const int i : range(num_tasks)) {
+      EXPECT_EQ(results[i], i * i);
+    }
+  }
+}
+
+TEST(ParallelUtilTest, ParallelForWorkStealingNested) {
+  const int num_tasks = 50;
+  const auto sums = mapped_parallel(std::vector{1, 2, 3, 4, 5, 6, 7, 8}, [&](int x) {
+    std::vector<int> results(num_tasks);
+    parallel_for_work_stealing(num_tasks, 0, [&](int i) {
+      results[i] = x * i;
+    });
+    return sum(results);
+  });
+  for (const int i : range(sums.size())) {
+    EXPECT_EQ(sums[i], (i + 1) * num_tasks * (num_tasks - 1) / 2);
+  }
+}
@@ -404,6 +404,34 @@ TEST(QLiTest, QLiSymmBuiltinProjection) {
   );
 }
 
+TEST(QLiTest, CanonicalizedCache) {
+  const auto base = QLi3(1,2,3,4,5,6);
+  const auto hits_before = QLi_cache_stats().hits;
+  // Same structure, different variables: served from the cache entry for (1,2,3,4,5,6).
+  EXPECT_EXPR_EQ(QLi3(4,7,2,9,1,3), substitute_variables_1_based(base, {4,7,2,9,1,3}));
+  EXPECT_EXPR_EQ(QLi3(2,3,4,5,6,7), substitute_variables_1_based(base, {2,3,4,5,6,7}));
+  EXPECT_GE(QLi_cache_stats().hits, hits_before + 2);
+  // Repeated variables and constant points.
+  EXPECT_EXPR_EQ(QLi2(1,2,1,3), substitute_variables_1_based(QLi2(3,1,3,2), {2,3,1}));
+  EXPECT_EXPR_EQ(
+    QLi2(1,2,Inf,3),
+    substitute_variables_1_based(QLi2(2,3,Inf,1), {3,1,2})
+  );
+}
+
+TEST(QLiTest, CacheDisabled) {
+  const auto expected = QLi4(1,2,3,4,5,6);
+  QLi_set_cache_max_bytes(0);
+  const auto stats_before = QLi_cache_stats();
+  EXPECT_EXPR_EQ(QLi4(1,2,3,4,5,6), expected);
+  EXPECT_EXPR_EQ(QLi4(2,3,4,5,6,7), substitute_variables_1_based(expected, {2,3,4,5,6,7}));
+  const auto stats_after = QLi_cache_stats();
+  EXPECT_EQ(stats_after.hits, stats_before.hits);
+  EXPECT_EQ(stats_after.misses, stats_before.misses);
+  EXPECT_EQ(stats_after.num_entries, 0);
+  QLi_set_cache_max_bytes(size_t(256) << 20);
+}
+
 
 TEST(QLiTest, LARGE_QLiSymm4_Arg6_AsCyclicSums) {
   const auto z = QLiSymm4(1,2,3,4,5,6);
@@ -6,6 +6,32 @@
 #include "test_util/matchers.h"
 
 
+using Word = std::vector<int>;
+using WordExpr = BasicLinear<SimpleLinearParam<Word>>;
+
+struct ModPWordParam : SimpleLinearParam<Word> {
+  using CoeffT = ModP<7>;
+};
+using ModPWordExpr = BasicLinear<ModPWordParam>;
+
+// Straightforward implementation of the definition.
+static WordExpr shuffle_product_reference(const Word& u, const Word& v) {
+  if (u.empty() || v.empty()) {
+    return WordExpr::single(u.empty() ? v : u);
+  }
+  WordExpr ret;
+  shuffle_product_reference(u, slice(v, 0, v.size() - 1)).foreach([&](Word w, int coeff) {
+    w.push_back(v.back());
+    ret.add_to(w, coeff);
+  });
+  shuffle_product_reference(slice(u, 0, u.size() - 1), v).foreach([&](Word w, int coeff) {
+    w.push_back(u.back());
+    ret.add_to(w, coeff);
+  });
+  return ret;
+}
+
+
 TEST(ShuffleProductTest, ThreeExpressions) {
   EXPECT_EXPR_EQ(
     shuffle_product(std::vector{
@@ -30,3 +56,61 @@ TEST(ShuffleProductTest, ThreeExpressions) {
     ).main()
   );
 }
+
+TEST(ShuffleProductTest, TwoWords) {
+  const std::vector<std::pair<Word, Word>> cases = {
+    {{1}, {2}},
+    {{1, 1}, {1}},
+    {{1, 2, 3}, {4, 5}},
+    {{1, 2, 1, 2}, {2, 1, 2, 1, 2}},
+    {{1, 2, 3, 4, 5, 6}, {7, 8, 9, 10, 11}},
+    {{1, 1, 2, 2, 1, 3}, {3, 1, 2, 1, 1, 2, 3}},
+    {{1, 2, 3, 4, 5, 6, 7, 8, 9}, {1, 2, 1, 2, 1, 2, 1, 2, 1, 2}},  // too large for a template
+  };
+  for (const auto& [u, v] : cases) {
+    const auto result = shuffle_product(u, v);
+    EXPECT_EQ(result, shuffle_product_reference(u, v));
+    EXPECT_EQ(result.l1_norm(), internal::num_interleavings(u.size(), v.size()));
+  }
+}
+
+TEST(ShuffleProductTest, MultipleWords) {
+  const std::vector<std::vector<Word>> cases = {
+    {{1}, {2}, {3}},
+    {{1, 2}, {}, {2, 1}},
+    {{1, 2, 3}, {4}, {5, 6}, {7}},
+    {{1, 1, 2}, {2, 2, 1}, {1, 2, 1, 2}},
+    {{1, 2, 3, 4}, {1, 2, 3, 4}, {5, 4, 3, 2, 1}},  // too large for a template
+  };
+  for (const auto& words : cases) {
+    WordExpr expected = WordExpr::single({});
+    for (const auto& w : words) {
+      expected = expected.mapped_expanding([&](const Word& u) {
+        return shuffle_product_reference(u, w);
+      });
+    }
+    EXPECT_EQ(shuffle_product(words), expected);
+  }
+}
+
+TEST(ShuffleProductTest, EmptyWords) {
+  EXPECT_EQ(shuffle_product(std::vector<Word>{}), WordExpr{});
+  EXPECT_EQ(shuffle_product(std::vector<Word>{{}}), WordExpr::single({}));
+  EXPECT_EQ(shuffle_product(std::vector<Word>{{}, {1, 2}, {}}), WordExpr::single({1, 2}));
+}
+
+TEST(ShuffleProductTest, ModPCoeff) {
+  const std::vector<std::pair<Word, Word>> cases = {
+    {{1, 2}, {1, 2}},
+    {{1, 1, 1}, {1, 1, 1, 1}},
+    {{1, 2, 3, 4, 5, 6, 7, 8, 9}, {1, 2, 1, 2, 1, 2, 1, 2, 1, 2}},  // too large for a template
+  };
+  for (const auto& [u, v] : cases) {
+    const auto result = internal::shuffle_product_impl<ModPWordExpr>(u, v);
+    const auto expected = shuffle_product(u, v);
+    EXPECT_LE(result.num_terms(), expected.num_terms());
+    expected.foreach_key([&](const Word& w, int coeff) {
+      EXPECT_EQ(result.coeff_for_key(w), ModP<7>(coeff));
+    });
+  }
+}
@@ -0,0 +1,105 @@
+#include "lib/small_vector.h"
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include "absl/hash/hash_testing.h"
+
+#include "lib/util.h"
+
+
+using testing::ElementsAre;
+using testing::ElementsAreArray;
+
+using Vec = SmallVector<unsigned char>;
+
+static Vec V(const std::vector<unsigned char>& data) {
+  return Vec(data.begin(), data.end());
+}
+
+// Returns a vector with the given contents that lives on heap even if it's short.
+static Vec heap_V(const std::vector<unsigned char>& data) {
+  Vec ret;
+  ret.reserve(Vec::kInlineCapacity + 1);
+  ret.insert(ret.end(), data.begin(), data.end());
+  return ret;
+}
+
+static const std::vector<std::vector<unsigned char>> kTestVectors = {
+  {},
+  {0},
+  {0, 0},
+  {1},
+  {1, 0},
+  {0, 1},
+  {1, 2, 3},
+  {1, 2, 4},
+  {255, 0, 255},
+  {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14},
+  {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+  {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0},
+  {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20},
+};
+
+
+TEST(SmallVectorTest, Basic) {
+  Vec v;
+  EXPECT_TRUE(v.empty());
+  EXPECT_TRUE(v.is_inlined());
+  for (int i : range(20)) {
+    v.push_back(i);
+    EXPECT_EQ(v.is_inlined(), v.size() <= Vec::kInlineCapacity);
+  }
+  EXPECT_EQ(v.size(), 20);
+  EXPECT_EQ(v.back(), 19);
+  v.erase(v.begin() + 1, v.end() - 1);
+  EXPECT_THAT(v, ElementsAre(0, 19));
+  v.insert(v.begin() + 1, {7, 8});
+  EXPECT_THAT(v, ElementsAre(0, 7, 8, 19));
+  v.resize(2);
+  EXPECT_THAT(v, ElementsAre(0, 7));
+}
+
+TEST(SmallVectorTest, CopyAndMove) {
+  for (const auto& data : kTestVectors) {
+    const Vec a = V(data);
+    Vec b = a;
+    EXPECT_THAT(b, ElementsAreArray(data));
+    Vec c = std::move(b);
+    EXPECT_THAT(c, ElementsAreArray(data));
+    EXPECT_TRUE(b.empty());
+    b = c;
+    c = std::move(b);
+    EXPECT_THAT(c, ElementsAreArray(data));
+  }
+}
+
+TEST(SmallVectorTest, InsertAliased) {
+  Vec v = V({1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+  v.insert(v.begin() + 1, v.begin(), v.end());
+  EXPECT_THAT(v, ElementsAre(1, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 2, 3, 4, 5, 6, 7, 8, 9, 10));
+}
+
+TEST(SmallVectorTest, CompareAsVectors) {
+  for (const auto& a : kTestVectors) {
+    for (const auto& b : kTestVectors) {
+      EXPECT_EQ(V(a) == V(b), a == b) << dump_to_string(a) << " vs " << dump_to_string(b);
+      EXPECT_EQ(V(a) == heap_V(b), a == b) << dump_to_string(a) << " vs " << dump_to_string(b);
+      EXPECT_EQ(V(a) < V(b), a < b) << dump_to_string(a) << " vs " << dump_to_string(b);
+    }
+  }
+}
+
+TEST(SmallVectorTest, PopBackKeepsInlineRepresentationCanonical) {
+  Vec a = V({1, 2, 3});
+  a.pop_back();
+  EXPECT_EQ(a, V({1, 2}));
+  a.clear();
+  EXPECT_EQ(a, Vec());
+}
+
+TEST(SmallVectorTest, Hash) {
+  std::vector<Vec> values = mapped(kTestVectors, V);
+  append_vector(values, mapped(kTestVectors, heap_V));
+  EXPECT_TRUE(absl::VerifyTypeImplementsAbslHashCorrectly(values));
+}
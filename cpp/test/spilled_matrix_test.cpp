@@ -0,0 +1,103 @@
+#include "lib/spilled_matrix.h"
+
+#include "gtest/gtest.h"
+
+#include "lib/polylog_gr_space.h"
+#include "lib/range.h"
+#include "lib/space_algebra.h"
+#include "test_util/matchers.h"
+
+
+// Block diagonal matrix with blocks of size 1, 2, ..., `num_blocks`. Block of size `n` has rank
+// `n-1` (consecutive differences), except for the block of size 1 which has rank 1.
+static std::vector<std::vector<std::pair<int, int>>> make_block_diagonal_cols(int num_blocks, int* num_rows) {
+  std::vector<std::vector<std::pair<int, int>>> cols;
+  *num_rows = 0;
+  for (const int n : range_incl(1, num_blocks)) {
+    for (const int i : range(n)) {
+      std::vector<std::pair<int, int>> col;
+      col.push_back({*num_rows + i, 1});
+      if (n > 1) {
+        col.push_back({*num_rows + (i + 1) % n, -1});
+      }
+      cols.push_back(col);
+    }
+    *num_rows += n;
+  }
+  return cols;
+}
+
+static std::string write_spilled_matrix(
+  const std::string& name,
+  const std::vector<std::vector<std::pair<int, int>>>& cols,
+  int num_rows
+) {
+  const std::string filename = testing::TempDir() + name;
+  SpilledMatrixWriter writer(filename, /* buffer_bytes = */ 64);
+  for (const auto& col : cols) {
+    writer.add_col(col);
+  }
+  writer.finish(num_rows);
+  return filename;
+}
+
+
+TEST(SpilledMatrixTest, RoundTrip) {
+  int num_rows = 0;
+  const auto cols = make_block_diagonal_cols(6, &num_rows);
+  const SpilledMatrix spilled(write_spilled_matrix("spilled_round_trip.bin", cols, num_rows));
+  EXPECT_EQ(spilled.rows(), num_rows);
+  EXPECT_EQ(spilled.cols(), cols.size());
+  EXPECT_EQ(spilled.num_nonzero(), 1 + 2 * (2 + 3 + 4 + 5 + 6));
+  EXPECT_MATRIX_EQ(spilled.to_compressed_matrix(), CompressedMatrix::from_sparse_cols(num_rows, cols));
+}
+
+TEST(SpilledMatrixTest, Empty) {
+  const SpilledMatrix spilled(write_spilled_matrix("spilled_empty.bin", {}, 0));
+  EXPECT_EQ(matrix_rank_out_of_core(spilled), 0);
+}
+
+TEST(SpilledMatrixTest, SpaceRankOutOfCore) {
+  const auto space = GrL2(3, {1,2,3,4,5,6});
+  EXPECT_EQ(
+    space_rank_out_of_core(space, DISAMBIGUATE(to_lyndon_basis), testing::TempDir() + "spilled_space.bin"),
+    space_rank(space, DISAMBIGUATE(to_lyndon_basis))
+  );
+}
+
+class SpilledMatrixRankTest : public testing::TestWithParam<RankBackend> {};
+
+TEST_P(SpilledMatrixRankTest, OutOfCoreRank) {
+  int num_rows = 0;
+  const auto cols = make_block_diagonal_cols(10, &num_rows);
+  const SpilledMatrix spilled(write_spilled_matrix("spilled_rank.bin", cols, num_rows));
+  const int expected_rank = 1 + (1 + 2 + 3 + 4 + 5 + 6 + 7 + 8 + 9);
+  for (const int64_t max_nonzero_in_memory : {1, 10, 1000}) {
+    MatrixRankStats stats;
+    EXPECT_EQ(matrix_rank_out_of_core(spilled, GetParam(), max_nonzero_in_memory, &stats), expected_rank);
+    EXPECT_EQ(stats.blocks.size(), 10);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  AllBackends, SpilledMatrixRankTest,
+  testing::Values(RankBackend::exact, RankBackend::modular)
+);
+
+TEST(SpilledMatrixTest, BinaryTriplets) {
+  Matrix m(4, 5);
+  m(0, 4) = 3;
+  m(3, 0) = -1;
+  m(1, 2) = 7;
+  m(3, 2) = 2;
+  const std::string text_filename = testing::TempDir() + "triplets.txt";
+  const std::string binary_filename = testing::TempDir() + "triplets.bin";
+  const std::string converted_filename = testing::TempDir() + "triplets_converted.bin";
+  save_triplets(text_filename, m);
+  save_triplets_binary(binary_filename, m);
+  convert_triplets_to_binary(text_filename, converted_filename);
+  EXPECT_MATRIX_EQ(load_triplets(text_filename), m);
+  EXPECT_MATRIX_EQ(load_triplets_binary(binary_filename).to_compressed_matrix(), m);
+  EXPECT_MATRIX_EQ(load_triplets_binary(converted_filename).to_compressed_matrix(), m);
+  EXPECT_EQ(matrix_rank_out_of_core(load_triplets_binary(binary_filename)), 3);
+}
@@ -39,3 +39,7 @@ void EXPECT_EXPR_ZERO_AFTER_LYNDON(const LinearT& expr) {
 void EXPECT_MATRIX_EQ(const Matrix& a, const Matrix& b) {
   EXPECT_TRUE(a == b) << to_string(a) << "vs\n" << to_string(b);
 }
+
+void EXPECT_MATRIX_EQ(const CompressedMatrix& a, const CompressedMatrix& b) {
+  EXPECT_TRUE(a == b) << to_string(a) << "vs\n" << to_string(b);
+}
@@ -23,6 +23,8 @@ void pybind_polylog(py::module_& m) {
   m.def("QLiNegPr", &QLiNegVecPr);
   m.def("QLiSymmPr", &QLiSymmVecPr);
 
+  m.def("QLi_clear_cache", &QLi_clear_cache);
+
   m.def("A2", &A2Vec);
 
   // limitation: monsters are not supported
@@ -1,10 +1,33 @@
 import scipy.sparse
 import argparse
+import struct
+
+import numpy as np
 
 parser = argparse.ArgumentParser(description='Converts .npz matrix to triplets (row, col, value)')
 parser.add_argument('filename')
+parser.add_argument(
+    '--binary',
+    metavar='OUTPUT',
+    help='write binary triplets to OUTPUT instead (see `load_triplets_binary` in cpp/lib/spilled_matrix.h)',
+)
 args = parser.parse_args()
 
-mat = scipy.sparse.load_npz(args.filename).tocoo()
-for row, col, value in zip(mat.row, mat.col, mat.data):
-    print(row, col, value)
+mat = scipy.sparse.load_npz(args.filename)
+if args.binary:
+    mat = mat.tocsc()
+    mat.eliminate_zeros()
+    mat.sort_indices()
+    rows, cols = mat.shape
+    with open(args.binary, 'wb') as f:
+        # Must match `SpilledMatrixHeader`.
+        f.write(struct.pack('=8siiiiq', b'PKSPILL\0', 1, rows, cols, 0, mat.nnz))
+        for col in range(cols):
+            begin, end = mat.indptr[col], mat.indptr[col + 1]
+            f.write(np.int32(end - begin).tobytes())
+            elements = np.column_stack((mat.indices[begin:end], mat.data[begin:end]))
+            f.write(elements.astype(np.int32).tobytes())
+else:
+    mat = mat.tocoo()
+    for row, col, value in zip(mat.row, mat.col, mat.data):
+        print(row, col, value)
@@ -58,6 +58,7 @@ QLiSymm = pb.QLiSymm
 QLiPr = pb.QLiPr
 QLiNegPr = pb.QLiNegPr
 QLiSymmPr = pb.QLiSymmPr
+QLi_clear_cache = pb.QLi_clear_cache
 
 Lira = pb.Lira
 